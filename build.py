@@ -19,6 +19,7 @@ with open('build_config.json') as file:
     config      = 'Debug' if data['debug_build'] else 'Release'
     target      = data['target']
     build_tests = data['build_tests']
+    build_bench = data.get('build_benchmarks', False)
 
     if not target in target_values :
         raise Exception('build_config.json bad "target" value')
@@ -29,7 +30,8 @@ with open('build_config.json') as file:
         '-DCMAKE_BUILD_TYPE=' + config,
         '-DBUILD_CLIENT='     + str(target == 'client' or target == 'all'),
         '-DBUILD_SERVER='     + str(target == 'server' or target == 'all'),
-        '-DBUILD_TESTS='      + str(build_tests)
+        '-DBUILD_TESTS='      + str(build_tests),
+        '-DBUILD_BENCHMARKS=' + str(build_bench)
     ]
 
 # Reset the build folder
@@ -4,6 +4,7 @@
 #include <reactor.hpp>
 #include <terminal.hpp>
 #include <logger.hpp>
+#include <serialization_stats.hpp>
 #include <SFML/Network.hpp>
 #include <thread>
 
@@ -54,8 +55,14 @@ int main() {
 				return true;
 			});
 		};
+#if defined(NABU_SERIALIZATION_STATS)
+		terminal.commands["serialization_stats"] = [](auto&) {
+			logger.info("{}", serialization_stats.report());
+		};
+#endif
 		while (true) {
 			reactor.update();
+			if (socket.is_connected()) socket.flush();
 			std::this_thread::sleep_for(20ms);
 		}
 	}
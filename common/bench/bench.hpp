@@ -0,0 +1,70 @@
+#pragma once
+
+#include <fmt/format.h>
+#include <atomic>
+#include <chrono>
+#include <string_view>
+
+
+namespace nabu::bench {
+
+// Number of calls to 'operator new' since the start of the program.
+// Maintained by the replacement of the global allocation functions in main.cpp.
+
+size_t allocation_count() noexcept;
+
+// Prevents the compiler from discarding a computation whose result is unused.
+
+template <class T>
+void do_not_optimize(T const& val) noexcept {
+    static void const* volatile sink;
+    sink = &val;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+}
+
+// Runs benchmarks and prints one JSON object per line, for each of them :
+//   { "name", "policy", "operation", "ns_per_op", "bytes_per_op", "allocs_per_op" }
+// Benchmarks whose name does not contain the filter are skipped.
+
+class runner {
+    using clock = std::chrono::steady_clock;
+
+    static constexpr int warmup_iterations = 100;
+    static constexpr int batch_iterations  = 100;
+    static constexpr auto min_duration     = std::chrono::milliseconds{ 100 };
+
+    std::string_view filter_;
+
+public:
+    explicit runner(std::string_view const filter = {}) noexcept :
+        filter_{ filter } {}
+
+    // Measures 'operation', processing 'bytes' bytes each time it's called.
+    template <class F>
+    void run(std::string_view const name, std::string_view const policy,
+             std::string_view const operation, int const bytes, F&& f) {
+        if (name.find(filter_) == std::string_view::npos)
+            return;
+
+        for (int i = 0; i < warmup_iterations; ++i) f();
+
+        size_t iterations = 0;
+        auto const allocations = allocation_count();
+        auto const start = clock::now();
+        auto elapsed = clock::duration{};
+        do {
+            for (int i = 0; i < batch_iterations; ++i) f();
+            iterations += batch_iterations;
+            elapsed = clock::now() - start;
+        } while (elapsed < min_duration);
+        auto const allocs = allocation_count() - allocations;
+
+        auto const ns = std::chrono::duration<double, std::nano>{ elapsed }.count();
+        fmt::print("{{\"name\":\"{}\",\"policy\":\"{}\",\"operation\":\"{}\","
+                   "\"ns_per_op\":{:.2f},\"bytes_per_op\":{},\"allocs_per_op\":{:.3f}}}\n",
+                   name, policy, operation, ns / iterations, bytes,
+                   static_cast<double>(allocs) / iterations);
+    }
+};
+
+}
@@ -0,0 +1,41 @@
+#include "bench.hpp"
+#include <cstdlib>
+#include <new>
+
+
+namespace {
+    std::atomic<size_t> allocations{ 0 };
+}
+
+void* operator new(size_t const size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (auto const ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* const ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* const ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+namespace nabu::bench {
+
+size_t allocation_count() noexcept {
+    return allocations.load(std::memory_order_relaxed);
+}
+
+void serialization_benchmarks(runner& runner);
+
+}
+
+// Usage : common_bench [filter]
+// Only the benchmarks whose name contains 'filter' are run.
+
+int main(int argc, char** argv) {
+    auto runner = nabu::bench::runner{ argc > 1 ? argv[1] : "" };
+    nabu::bench::serialization_benchmarks(runner);
+}
@@ -0,0 +1,203 @@
+#include "bench.hpp"
+#include <serialization.hpp>
+#include <checksum.hpp>
+#include <serialization_parallel.hpp>
+#include <msg/static_parser.hpp>
+#include <list>
+#include <map>
+#include <set>
+#include <unordered_map>
+
+
+namespace {
+    struct vec3_t {
+        float x, y, z;
+    };
+
+    struct entity_t {
+        int id;
+        std::string name;
+        vec3_t position;
+        std::vector<int> items;
+    };
+
+    struct custom_t { int i; };
+
+    struct move_t {
+        static constexpr nabu::id_type id = 1;
+        int entity;
+        vec3_t position;
+    };
+
+    struct say_t {
+        static constexpr nabu::id_type id = 2;
+        int entity;
+        std::string text;
+    };
+
+    constexpr int custom_serialized_size(custom_t const&) noexcept {
+        return sizeof(int);
+    }
+    int custom_serialized_size(nabu::buffer_span const& span, nabu::type_tag<custom_t>) noexcept {
+        return span.size() >= sizeof(int) ? sizeof(int) : nabu::invalid_serialized_size;
+    }
+    void custom_serialize(nabu::buffer_span& span, custom_t const& val) {
+        nabu::serialize(span, val.i);
+    }
+    void custom_deserialize(nabu::buffer_span& span, custom_t& val) {
+        nabu::deserialize(span, val.i);
+    }
+}
+
+namespace nabu::bench {
+
+namespace {
+    template <class Stream, class T>
+    void run_policy(runner& runner, std::string_view const name, std::string_view const policy,
+                    T const& value, std::vector<std::byte>& buffer) {
+        int const size = static_cast<int>(buffer.size());
+
+        runner.run(name, policy, "serialize", size, [&] {
+            auto stream = Stream{ buffer };
+            stream << value;
+            do_not_optimize(stream.begin);
+        });
+
+        // The same object is reused, as a connection does with it's messages.
+        T copy{};
+        runner.run(name, policy, "deserialize", size, [&] {
+            auto stream = Stream{ buffer };
+            stream >> copy;
+            do_not_optimize(copy);
+        });
+    }
+
+    template <class T>
+    void run_type(runner& runner, std::string_view const name, T const& value) {
+        int const size = serialized_size(value);
+        auto buffer = std::vector<std::byte>(size);
+
+        runner.run(name, "none", "serialized_size", size, [&] {
+            do_not_optimize(serialized_size(value));
+        });
+
+        auto stream = throw_stream{ buffer };
+        stream << value;
+        runner.run(name, "none", "serialized_size_span", size, [&] {
+            auto const span = buffer_span{ buffer.data(), buffer.data() + buffer.size() };
+            do_not_optimize(serialized_size(span, type_tag<T>{}));
+        });
+
+        run_policy<raw_stream>    (runner, name, "raw",      value, buffer);
+        run_policy<checked_stream>(runner, name, "checked",  value, buffer);
+        run_policy<throw_stream>  (runner, name, "throwing", value, buffer);
+    }
+
+    // Measures the parallel serialization, to compare with the 'raw' policy.
+    template <class T>
+    void run_parallel(runner& runner, std::string_view const name, T const& value) {
+        int const size = serialized_size(value);
+        auto buffer = std::vector<std::byte>(size);
+
+        runner.run(name, "raw", "serialize", size, [&] {
+            auto span = buffer_span{ buffer.data(), buffer.data() + size };
+            serialize(span, value);
+            do_not_optimize(span.begin);
+        });
+        runner.run(name, "parallel", "serialize", size, [&] {
+            auto span = buffer_span{ buffer.data(), buffer.data() + size };
+            parallel_serialize(span, value);
+            do_not_optimize(span.begin);
+        });
+    }
+
+    // Measures the dispatch of 100 small messages, by the runtime and the static parser.
+    void run_dispatch(runner& runner) {
+        auto buffer = std::vector<std::byte>(100 * 64);
+        auto stream = throw_stream{ buffer };
+        auto sender = msg::parser{};
+        for (int i = 0; i < 50; ++i) {
+            sender.serialize(stream, move_t{ i, { 1.f, 2.f, 3.f } });
+            sender.serialize(stream, say_t{ i, "hello" });
+        }
+        auto const frames = buffer_span{ buffer.data(), stream.begin };
+        int const size = frames.size();
+
+        int total = 0;
+        auto parser = msg::parser{};
+        parser.set_callback([&] (move_t const& m) { total += m.entity; });
+        parser.set_callback([&] (say_t const& m) { total += m.entity; });
+        runner.run("messages/move,say[100]", "parser", "dispatch", size, [&] {
+            auto span = throw_stream{ frames.begin, frames.end };
+            while (!span.is_empty()) parser.deserialize(span);
+            do_not_optimize(total);
+        });
+
+        auto static_parser = msg::static_parser<move_t, say_t>{};
+        auto const handler = overloaded{
+            [&] (move_t const& m) { total += m.entity; },
+            [&] (say_t const& m) { total += m.entity; }
+        };
+        runner.run("messages/move,say[100]", "static_parser", "dispatch", size, [&] {
+            auto span = throw_stream{ frames.begin, frames.end };
+            while (!span.is_empty()) static_parser.deserialize(span, handler);
+            do_not_optimize(total);
+        });
+    }
+
+    // Measures the cost of the checksum, to compare with the 'throwing' policy.
+    template <class T>
+    void run_checksum(runner& runner, std::string_view const name, T const& value) {
+        int const size = serialized_size(value) + sizeof(uint32_t);
+        auto buffer = std::vector<std::byte>(size);
+
+        runner.run(name, "throwing+crc32c", "serialize", size, [&] {
+            auto stream = throw_stream{ buffer };
+            auto checksum = checksum_stream{ stream };
+            checksum << value;
+            checksum.write_trailer();
+            do_not_optimize(stream.begin);
+        });
+    }
+}
+
+void serialization_benchmarks(runner& runner) {
+    auto entity = entity_t{ 42, "goblin", { 1.f, 2.f, 3.f }, { 1, 2, 3, 4, 5, 6, 7, 8 } };
+
+    auto names = std::vector<std::string>{};
+    for (int i = 0; i < 100; ++i) names.push_back(fmt::format("name {}", i));
+
+    auto scores = std::map<std::string, int>{};
+    for (int i = 0; i < 100; ++i) scores.emplace(fmt::format("player {}", i), i);
+
+    auto ids = std::set<int>{};
+    auto owners = std::unordered_map<int, int>{};
+    for (int i = 0; i < 1000; ++i) ids.insert(i), owners.emplace(i, i);
+
+    run_type(runner, "trivial/int",               42);
+    run_type(runner, "trivial/vec3",              vec3_t{ 1.f, 2.f, 3.f });
+    run_type(runner, "array/vector<int>[1000]",   std::vector<int>(1000, 42));
+    run_type(runner, "array/string[64]",          std::string(64, 'a'));
+    run_type(runner, "iterable/list<int>[100]",   std::list<int>(100, 42));
+    run_type(runner, "iterable/vector<string>[100]", names);
+    run_type(runner, "iterable/map<string,int>[100]", scores);
+    run_type(runner, "iterable/set<int>[1000]",   ids);
+    run_type(runner, "iterable/unordered_map<int,int>[1000]", owners);
+    run_type(runner, "aggregate/entity",          entity);
+    run_type(runner, "iterable/vector<entity>[100]", std::vector<entity_t>(100, entity));
+    run_type(runner, "columnar/vector<entity>[100]", columnar_vector<entity_t>(100, entity));
+    run_type(runner, "tuple/int,string,double",   std::tuple<int, std::string, double>{ 1, "tuple", 2. });
+    run_type(runner, "optional/string",           std::optional<std::string>{ "optional" });
+    run_type(runner, "optional/empty",            std::optional<std::string>{});
+    run_type(runner, "custom/custom",             custom_t{ 42 });
+
+    run_checksum(runner, "array/vector<int>[1000]",      std::vector<int>(1000, 42));
+    run_checksum(runner, "iterable/vector<entity>[100]", std::vector<entity_t>(100, entity));
+
+    run_parallel(runner, "array/vector<int>[1000000]",         std::vector<int>(1'000'000, 42));
+    run_parallel(runner, "iterable/vector<entity>[100000]",    std::vector<entity_t>(100'000, entity));
+
+    run_dispatch(runner);
+}
+
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <serialization.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+namespace nabu {
+
+// An archive stores serialized objects identified by a key, and reads them without
+// deserializing the rest of the file :
+//
+//   - header : magic number 'NABA' and format version, as uint32.
+//   - index :  the entries sorted by key (offset, key, size), serialized as a std::vector.
+//   - data :   the serialized objects, at 'offset' from the start of this section.
+//
+// archive_view reads the index in place, so an archive can be memory mapped (see mapped_file)
+// and each entry read lazily. Entries holding views (eg. std::string_view) are decoded without
+// copies, and are valid while the archive bytes are.
+
+class archive_error : public std::runtime_error {
+public:
+    inline explicit archive_error(std::string const& str) :
+        std::runtime_error{ str } {}
+};
+
+namespace detail {
+    constexpr uint32_t archive_magic   = 0x4142414E; // "NABA"
+    constexpr uint32_t archive_version = 1;
+
+    struct archive_header {
+        uint32_t magic;
+        uint32_t version;
+    };
+
+    struct archive_entry {
+        uint64_t offset;
+        uint32_t key;
+        uint32_t size;
+    };
+}
+
+// Builds an archive in memory.
+
+class archive_writer {
+    std::vector<detail::archive_entry> index_;
+    std::vector<std::byte> data_;
+
+public:
+    // Serializes 'val' as the entry 'key'. Keys must be unique, 'finish' checks it.
+    template <class T>
+    void add(uint32_t const key, T const& val) {
+        int const size = serialized_size(val);
+        auto const offset = data_.size();
+        data_.resize(offset + size);
+
+        auto span = buffer_span{ data_.data() + offset, data_.data() + data_.size() };
+        serialize(span, val);
+        index_.push_back({ offset, key, static_cast<uint32_t>(size) });
+    }
+
+    size_t size() const noexcept { return index_.size(); }
+
+    // Returns the archive bytes. Throws an archive_error if a key was added twice.
+    std::vector<std::byte> finish() const;
+
+    // Writes the archive in a file. Throws an archive_error on failure, or if a key was added twice.
+    void save(std::string const& path) const;
+};
+
+// Reads an archive in a buffer, which must outlive it.
+
+class archive_view {
+    array_view<detail::archive_entry> index_;
+    buffer_span data_;
+
+public:
+    // Throws an archive_error if 'bytes' does not start with a valid archive header and index,
+    // whose keys are sorted and unique.
+    explicit archive_view(buffer_span const& bytes);
+
+    size_t size() const noexcept { return index_.size(); }
+
+    // Returns the serialized bytes of the entry 'key', or an empty span without begin
+    // if the archive has no such entry.
+    buffer_span find(uint32_t key) const noexcept;
+
+    bool contains(uint32_t const key) const noexcept {
+        return find(key).begin != nullptr;
+    }
+
+    // Deserializes the entry 'key' in 'val'. Returns false if there is no such entry or
+    // if it's bytes are not exactly a serialized T.
+    template <class T>
+    bool try_read(uint32_t const key, T& val) const {
+        auto span = find(key);
+        if (!span.begin) return false;
+        return try_deserialize(span, val) && span.is_empty();
+    }
+
+    // Same as try_read, but throws an archive_error on failure.
+    template <class T>
+    void read(uint32_t const key, T& val) const {
+        if (!try_read(key, val)) throw archive_error{ fmt::format(
+            "Tried to read a '{}' from the archive entry {}, which is missing or invalid",
+            name_of<T>(), key )};
+    }
+};
+
+// A file mapped in memory, copy-on-write : changes to the bytes are not written to the file.
+
+class mapped_file {
+    std::byte* data_;
+    size_t size_;
+
+public:
+    // Throws an archive_error if the file cannot be mapped.
+    explicit mapped_file(std::string const& path);
+    ~mapped_file();
+
+    mapped_file(mapped_file&& rhs) noexcept;
+    mapped_file& operator=(mapped_file&& rhs) noexcept;
+
+    buffer_span bytes() const noexcept { return { data_, data_ + size_ }; }
+    size_t size() const noexcept { return size_; }
+};
+
+} // nabu
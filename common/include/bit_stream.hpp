@@ -0,0 +1,388 @@
+#pragma once
+
+#include <serialization.hpp>
+#include <cmath>
+
+
+namespace nabu {
+
+namespace detail {
+    constexpr int bit_width(uint64_t n) noexcept {
+        int width = 0;
+        while (n != 0) {
+            n >>= 1;
+            ++width;
+        }
+        return width;
+    }
+}
+
+// Field annotations, used by the bit stream to pack values in the minimum number of bits.
+// With byte streams, they are serialized as their underlying value, their 'serial_representation'.
+//
+//   - ranged<Min, Max> :          an integer in [Min, Max].
+//   - enumerated<Enum, Count> :   an enum with values in [0, Count[.
+//   - quantized<Min, Max, Steps>: a float in [Min, Max], with a precision of 1 / Steps.
+//
+// User annotations must expose 'static constexpr int bits', 'uint64_t to_bits() const'
+// and 'bool from_bits(uint64_t)' (which returns false if the bits are not a valid value).
+
+template <auto Min, auto Max>
+struct ranged {
+    static_assert(std::is_integral_v<decltype(Min)> && std::is_same_v<decltype(Min), decltype(Max)>,
+        "ranged bounds must be integers of the same type");
+    static_assert(Min <= Max, "ranged<Min, Max> requires Min <= Max");
+
+    using value_type = decltype(Min);
+    using serial_representation = value_type;
+    static constexpr int bits = detail::bit_width(static_cast<uint64_t>(Max) - static_cast<uint64_t>(Min));
+
+    value_type value;
+
+    constexpr ranged(value_type const v = Min) noexcept : value{ v } {}
+    constexpr operator value_type() const noexcept { return value; }
+
+    uint64_t to_bits() const noexcept {
+        NABU_ASSERT(value >= Min && value <= Max, "ranged value {} not in [{}, {}]", value, Min, Max);
+        return static_cast<uint64_t>(value) - static_cast<uint64_t>(Min);
+    }
+    bool from_bits(uint64_t const bits) noexcept {
+        if (bits > static_cast<uint64_t>(Max) - static_cast<uint64_t>(Min)) return false;
+        value = static_cast<value_type>(static_cast<uint64_t>(Min) + bits);
+        return true;
+    }
+};
+
+template <class Enum, size_t Count>
+struct enumerated {
+    static_assert(Count > 0, "enumerated<Enum, Count> requires Count > 0");
+
+    using serial_representation = Enum;
+    static constexpr int bits = detail::bit_width(Count - 1);
+
+    Enum value;
+
+    constexpr enumerated(Enum const v = Enum{}) noexcept : value{ v } {}
+    constexpr operator Enum() const noexcept { return value; }
+
+    uint64_t to_bits() const noexcept {
+        auto const bits = static_cast<uint64_t>(value);
+        NABU_ASSERT(bits < Count, "enumerated value {} not in [0, {}[", bits, Count);
+        return bits;
+    }
+    bool from_bits(uint64_t const bits) noexcept {
+        if (bits >= Count) return false;
+        value = static_cast<Enum>(bits);
+        return true;
+    }
+};
+
+template <int Min, int Max, int Steps>
+struct quantized {
+    static_assert(Min < Max && Steps > 0, "quantized<Min, Max, Steps> requires Min < Max and Steps > 0");
+
+    static constexpr uint64_t max_step = static_cast<uint64_t>(Max - Min) * Steps;
+    using serial_representation = float;
+    static constexpr int bits = detail::bit_width(max_step);
+
+    float value;
+
+    constexpr quantized(float const v = static_cast<float>(Min)) noexcept : value{ v } {}
+    constexpr operator float() const noexcept { return value; }
+
+    uint64_t to_bits() const noexcept {
+        auto const clamped = std::clamp(value, static_cast<float>(Min), static_cast<float>(Max));
+        return static_cast<uint64_t>(std::lround((clamped - Min) * Steps));
+    }
+    bool from_bits(uint64_t const bits) noexcept {
+        if (bits > max_step) return false;
+        value = Min + static_cast<float>(bits) / Steps;
+        return true;
+    }
+};
+
+template <class T>
+using bit_annotation_expression = decltype(T::bits, std::declval<T const&>().to_bits());
+
+template <class T>
+constexpr bool is_bit_annotation = is_detected<bit_annotation_expression, T>;
+
+// The bit stream packs values bit by bit :
+//
+//   - annotations use their 'bits', and booleans one bit.
+//   - other arithmetic types and enums use all their bits.
+//   - tuples, pairs and aggregates pack their members one after the other.
+//   - iterables pack their count (as a varint), then their elements. Arrays of arithmetic
+//     types are serialized as bytes, after aligning the stream on a byte.
+//   - other types are serialized as bytes, after aligning the stream on a byte.
+//
+// Like checked_stream, it's valid state is kept with the boolean 'error'.
+// 'flush' must be called after the last write, to write the last partial byte.
+
+namespace stream_policy {
+    struct bit_packed {};
+}
+
+namespace detail {
+    template <>
+    struct stream_mixin<stream_policy::bit_packed> {
+        uint64_t bits = 0;
+        int bit_count = 0;
+        bool error = false;
+    };
+}
+
+using bit_stream = basic_stream<stream_policy::bit_packed>;
+
+// Writes the 'count' lower bits of 'value'.
+
+inline void write_bits(bit_stream& stream, uint64_t value, int count) noexcept {
+    while (count > 0 && !stream.error) {
+        int const n = count < 32 ? count : 32;
+        stream.bits |= (value & ((uint64_t{ 1 } << n) - 1)) << stream.bit_count;
+        stream.bit_count += n;
+        value >>= n;
+        count -= n;
+        while (stream.bit_count >= 8) {
+            if (stream.is_empty()) {
+                stream.error = true;
+                return;
+            }
+            *stream.begin++ = static_cast<std::byte>(stream.bits);
+            stream.bits >>= 8;
+            stream.bit_count -= 8;
+        }
+    }
+}
+
+// Reads 'count' bits. Bytes are consumed from the span only when needed.
+
+inline uint64_t read_bits(bit_stream& stream, int count) noexcept {
+    uint64_t value = 0;
+    int shift = 0;
+    while (count > 0 && !stream.error) {
+        int const n = count < 32 ? count : 32;
+        while (stream.bit_count < n) {
+            if (stream.is_empty()) {
+                stream.error = true;
+                return 0;
+            }
+            stream.bits |= std::to_integer<uint64_t>(*stream.begin++) << stream.bit_count;
+            stream.bit_count += 8;
+        }
+        value |= (stream.bits & ((uint64_t{ 1 } << n) - 1)) << shift;
+        stream.bits >>= n;
+        stream.bit_count -= n;
+        shift += n;
+        count -= n;
+    }
+    return value;
+}
+
+// After writing, writes the last partial byte padded with zeros.
+
+inline void flush(bit_stream& stream) noexcept {
+    if (stream.bit_count > 0) write_bits(stream, 0, 8 - stream.bit_count);
+}
+
+// After reading, skips the remaining bits of the last read byte.
+
+inline void align(bit_stream& stream) noexcept {
+    stream.bits = 0;
+    stream.bit_count = 0;
+}
+
+namespace detail {
+    template <class T>
+    using pair_types = std::enable_if_t<std::is_same_v<T,
+        std::pair<typename T::first_type, typename T::second_type>>>;
+
+    enum class packing {
+        annotation,
+        boolean,
+        arithmetic,
+        bytes,
+        tuple,
+        pair,
+        iterable,
+        aggregate
+    };
+
+    template <class T>
+    constexpr packing packing_of() {
+        using tag_t = serial_tag_of<T>;
+        if constexpr (is_bit_annotation<T>)
+            return packing::annotation;
+        else if constexpr (std::is_same_v<T, bool>)
+            return packing::boolean;
+        else if constexpr ((std::is_arithmetic_v<T> || std::is_enum_v<T>) && sizeof(T) <= 8)
+            return packing::arithmetic;
+        else if constexpr (is_detected<tuple_tag, T>)
+            return packing::tuple;
+        else if constexpr (is_detected<pair_types, T>)
+            return packing::pair;
+        else if constexpr (std::is_same_v<tag_t, serial_tag::array>) {
+            using element_t = mutable_continuous_iterable_type<T>;
+            if constexpr (std::is_arithmetic_v<element_t> && !std::is_same_v<element_t, bool>)
+                 return packing::bytes;
+            else return packing::iterable;
+        }
+        else if constexpr (std::is_same_v<tag_t, serial_tag::iterable>)
+            return packing::iterable;
+        // Aggregates att can't decompose (having an array member or a base class) are packed as bytes.
+        else if constexpr (!std::is_same_v<tag_t, serial_tag::custom> && att::is_aggregate<T> &&
+                           (is_decomposable<T> || is_continuous_iterable<T>))
+            return packing::aggregate;
+        else
+            return packing::bytes;
+    }
+
+    template <class T>
+    constexpr int packed_bits();
+
+    template <class...Ts>
+    constexpr int packed_tuple_bits(type_tag<Ts...>) {
+        if constexpr ((true && ... && (packed_bits<Ts>() != dynamic_serialized_size)))
+             return (0 + ... + packed_bits<Ts>());
+        else return dynamic_serialized_size;
+    }
+
+    template <class T>
+    constexpr int packed_bits() {
+        using U = remove_deep_const<std::remove_reference_t<T>>;
+        constexpr auto kind = packing_of<U>();
+
+        if constexpr (kind == packing::annotation)
+            return U::bits;
+        else if constexpr (kind == packing::boolean)
+            return 1;
+        else if constexpr (kind == packing::arithmetic)
+            return 8 * sizeof(U);
+        else if constexpr (kind == packing::tuple)
+            return packed_tuple_bits(::nabu::tuple_tag<U>{});
+        else if constexpr (kind == packing::pair)
+            return packed_tuple_bits(type_tag<typename U::first_type, typename U::second_type>{});
+        else if constexpr (kind == packing::aggregate)
+            return packed_tuple_bits(::nabu::tuple_tag<att::to_tuple_t<U>>{});
+        else
+            return dynamic_serialized_size;
+    }
+}
+
+// packed_bits<T> is the number of bits of any packed T, or 'dynamic_serialized_size'
+// if it depends on it's value.
+
+template <class T>
+constexpr int packed_bits = detail::packed_bits<T>();
+
+namespace detail {
+    inline void write_packed_count(bit_stream& stream, size_t count) {
+        NABU_ASSERT_SERIALIZED_COUNT(count, count_encoding::varint);
+        while (count >= 0x80) {
+            write_bits(stream, (count & 0x7F) | 0x80, 8);
+            count >>= 7;
+        }
+        write_bits(stream, count, 8);
+    }
+    inline size_t read_packed_count(bit_stream& stream) noexcept {
+        size_t count = 0;
+        for (int i = 0; i < 5; ++i) {
+            auto const byte = read_bits(stream, 8);
+            count |= (byte & 0x7F) << (7 * i);
+            if (byte < 0x80) return count;
+        }
+        stream.error = true;
+        return 0;
+    }
+
+    template <class T>
+    void pack(bit_stream& stream, T const& val) {
+        constexpr auto kind = packing_of<T>();
+
+        if constexpr (kind == packing::annotation) {
+            write_bits(stream, val.to_bits(), T::bits);
+        }
+        else if constexpr (kind == packing::boolean) {
+            write_bits(stream, val ? 1 : 0, 1);
+        }
+        else if constexpr (kind == packing::arithmetic) {
+            uint_of_size<sizeof(T)> bits;
+            memcpy(&bits, &val, sizeof(T));
+            write_bits(stream, bits, 8 * sizeof(T));
+        }
+        else if constexpr (kind == packing::bytes) {
+            flush(stream);
+            if (!stream.error) stream.error = !try_serialize(stream, val);
+        }
+        else if constexpr (kind == packing::tuple) {
+            std::apply([&stream] (auto const&...vals) { (pack(stream, vals), ...); }, val);
+        }
+        else if constexpr (kind == packing::pair) {
+            pack(stream, val.first);
+            pack(stream, val.second);
+        }
+        else if constexpr (kind == packing::iterable) {
+            write_packed_count(stream, std::size(val));
+            for (auto const& v : val) pack(stream, v);
+        }
+        else {
+            std::apply([&stream] (auto const&...vals) { (pack(stream, vals), ...); }, att::as_tuple(val));
+        }
+    }
+
+    template <class T>
+    void unpack(bit_stream& stream, T& val) {
+        constexpr auto kind = packing_of<T>();
+
+        if constexpr (kind == packing::annotation) {
+            auto const bits = read_bits(stream, T::bits);
+            if (!stream.error && !val.from_bits(bits)) stream.error = true;
+        }
+        else if constexpr (kind == packing::boolean) {
+            val = read_bits(stream, 1) != 0;
+        }
+        else if constexpr (kind == packing::arithmetic) {
+            auto const bits = static_cast<uint_of_size<sizeof(T)>>(read_bits(stream, 8 * sizeof(T)));
+            memcpy(&val, &bits, sizeof(T));
+        }
+        else if constexpr (kind == packing::bytes) {
+            align(stream);
+            if (!stream.error) stream.error = !try_deserialize(stream, val);
+        }
+        else if constexpr (kind == packing::tuple) {
+            std::apply([&stream] (auto&...vals) { (unpack(stream, vals), ...); }, val);
+        }
+        else if constexpr (kind == packing::pair) {
+            unpack(stream, val.first);
+            unpack(stream, val.second);
+        }
+        else if constexpr (kind == packing::iterable) {
+            auto const count = read_packed_count(stream);
+            clear(val);
+            // A corrupted count must not trigger a huge allocation.
+            reserve(val, std::min(count, static_cast<size_t>(stream.size()) * 8));
+            mutable_iterable_type<T> v;
+            for (size_t i = 0; i < count && !stream.error; ++i) {
+                unpack(stream, v);
+                emplace_sorted(val, std::move(v));
+            }
+        }
+        else {
+            auto tuple = att::as_tuple(val);
+            std::apply([&stream] (auto&...vals) { (unpack(stream, vals), ...); }, tuple);
+        }
+    }
+}
+
+template <class T>
+bit_stream& operator<<(bit_stream& stream, T const& val) {
+    if (!stream.error) detail::pack(stream, val);
+    return stream;
+}
+template <class T>
+bit_stream& operator>>(bit_stream& stream, T& val) {
+    if (!stream.error) detail::unpack(stream, val);
+    return stream;
+}
+
+} // nabu
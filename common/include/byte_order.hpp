@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(_MSC_VER)
+    #include <stdlib.h>
+#endif
+
+
+namespace nabu {
+
+// The serialization wire format is little-endian. NABU_BIG_ENDIAN is defined on big-endian
+// hosts, which byte-swap the arithmetic types and enums. MSVC only targets little-endian CPUs.
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    #define NABU_BIG_ENDIAN
+    constexpr bool is_little_endian_host = false;
+#else
+    constexpr bool is_little_endian_host = true;
+#endif
+
+// uint_of_size<N> is the unsigned integer of N bytes.
+
+namespace detail {
+    template <size_t Size> struct uint_of_size_t;
+    template <> struct uint_of_size_t<1> { using type = uint8_t;  };
+    template <> struct uint_of_size_t<2> { using type = uint16_t; };
+    template <> struct uint_of_size_t<4> { using type = uint32_t; };
+    template <> struct uint_of_size_t<8> { using type = uint64_t; };
+}
+
+template <size_t Size>
+using uint_of_size = typename detail::uint_of_size_t<Size>::type;
+
+// Reverses the bytes of an unsigned integer.
+
+constexpr uint8_t byte_swap(uint8_t const val) noexcept { return val; }
+
+inline uint16_t byte_swap(uint16_t const val) noexcept {
+#if defined(_MSC_VER)
+    return _byteswap_ushort(val);
+#else
+    return __builtin_bswap16(val);
+#endif
+}
+
+inline uint32_t byte_swap(uint32_t const val) noexcept {
+#if defined(_MSC_VER)
+    return _byteswap_ulong(val);
+#else
+    return __builtin_bswap32(val);
+#endif
+}
+
+inline uint64_t byte_swap(uint64_t const val) noexcept {
+#if defined(_MSC_VER)
+    return _byteswap_uint64(val);
+#else
+    return __builtin_bswap64(val);
+#endif
+}
+
+// is_byte_swapped<T> indicates that the bytes of the arithmetic or enum type T are reversed
+// between the host and the wire.
+
+template <class T>
+constexpr bool is_byte_swapped =
+    !is_little_endian_host && (std::is_arithmetic_v<T> || std::is_enum_v<T>) && sizeof(T) > 1;
+
+// Converts 'val' between the host byte order and little-endian (the conversion is symmetric).
+
+template <class T>
+T to_little_endian(T val) noexcept {
+    if constexpr (is_byte_swapped<T>) {
+        uint_of_size<sizeof(T)> bits;
+        memcpy(&bits, &val, sizeof(T));
+        bits = byte_swap(bits);
+        memcpy(&val, &bits, sizeof(T));
+    }
+    return val;
+}
+
+template <class T>
+T from_little_endian(T const val) noexcept {
+    return to_little_endian(val);
+}
+
+// Reverses in place the bytes of 'count' values of 'Size' bytes. The loop has no dependency
+// between iterations, so it's vectorized into byte permutations (VSX, z/Architecture vector).
+
+template <size_t Size>
+void byte_swap_array(std::byte* data, size_t const count) noexcept {
+    for (size_t i = 0; i < count; ++i, data += Size) {
+        uint_of_size<Size> val;
+        memcpy(&val, data, Size);
+        val = byte_swap(val);
+        memcpy(data, &val, Size);
+    }
+}
+
+} // nabu
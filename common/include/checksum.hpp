@@ -0,0 +1,85 @@
+#pragma once
+
+#include <serialization.hpp>
+#include <cstdint>
+
+
+namespace nabu {
+
+// Returns the CRC32C (Castagnoli) of 'size' bytes, continuing the checksum 'crc'.
+// The first call takes 0. It uses the SSE4.2 or ARMv8 CRC instructions when the CPU
+// supports them, and a slicing-by-8 table otherwise.
+
+uint32_t crc32c(uint32_t crc, std::byte const* data, size_t size) noexcept;
+
+// Indicates that crc32c uses the CPU instructions.
+
+bool has_hardware_crc32c() noexcept;
+
+// checksum_stream wraps a basic_stream, and checksums the bytes serialized or deserialized
+// through it, right after each object : they are still in cache, so there is no second pass.
+// The frame is ended by a 4 bytes CRC32C trailer :
+//
+//   auto checksum = checksum_stream{ stream };
+//   checksum << header << level;             checksum >> header >> level;
+//   checksum.write_trailer();                if (!checksum.read_trailer()) ...
+//
+// Objects written directly in the wrapped stream are not checksummed.
+
+template <class StreamPolicy>
+class checksum_stream {
+    basic_stream<StreamPolicy>& stream_;
+    std::byte* checked_;
+    uint32_t crc_;
+
+    void update() noexcept {
+        crc_ = crc32c(crc_, checked_, stream_.begin - checked_);
+        checked_ = stream_.begin;
+    }
+
+public:
+    static constexpr int trailer_size = sizeof(uint32_t);
+
+    explicit checksum_stream(basic_stream<StreamPolicy>& stream) noexcept :
+        stream_ { stream },
+        checked_{ stream.begin },
+        crc_    { 0 } {}
+
+    template <class T>
+    checksum_stream& operator<<(T const& val) {
+        stream_ << val;
+        update();
+        return *this;
+    }
+
+    template <class T>
+    checksum_stream& operator>>(T& val) {
+        stream_ >> val;
+        update();
+        return *this;
+    }
+
+    // The checksum of the bytes serialized or deserialized so far.
+    uint32_t checksum() const noexcept { return crc_; }
+
+    basic_stream<StreamPolicy>& stream() noexcept { return stream_; }
+
+    // Writes the checksum in the wrapped stream, following it's policy on overflow.
+    void write_trailer() {
+        stream_ << crc_;
+    }
+
+    // Reads the checksum from the wrapped stream, and returns true if it matches the
+    // deserialized bytes. A truncated frame is a mismatch.
+    bool read_trailer() {
+        if (stream_.size() < trailer_size) return false;
+        uint32_t crc;
+        deserialize(stream_, crc);
+        return crc == crc_;
+    }
+};
+
+template <class StreamPolicy>
+checksum_stream(basic_stream<StreamPolicy>&) -> checksum_stream<StreamPolicy>;
+
+} // nabu
@@ -0,0 +1,266 @@
+#pragma once
+
+#include <serialization.hpp>
+#include <vector>
+
+
+namespace nabu {
+
+// A fast LZ77 codec, with the LZ4 block format : sequences of literals followed by a match
+// (2 bytes offset, lengths extended by runs of 255), the last sequence having only literals.
+// A dictionary primes the codec : the data is compressed as if the dictionary preceded it,
+// so it must be the same on both ends.
+
+namespace lz {
+    // The maximum compressed size of 'size' bytes.
+    constexpr int max_compressed_size(int const size) noexcept {
+        return size + size / 255 + 16;
+    }
+
+    // Compresses 'src' into 'dst', which must hold at least max_compressed_size(src.size()) bytes.
+    // Returns the compressed size.
+    int compress(array_view<std::byte> src, std::byte* dst, array_view<std::byte> dictionary = {});
+
+    // Decompresses 'src' into the 'dst_size' bytes of 'dst'.
+    // Returns false if 'src' is corrupted or does not decompress to exactly 'dst_size' bytes.
+    bool decompress(array_view<std::byte> src, std::byte* dst, int dst_size,
+                    array_view<std::byte> dictionary = {}) noexcept;
+}
+
+// Returns the given objects serialized back to back, to be used as a compression dictionary.
+// The best dictionaries are made of typical messages (eg. an empty level, a default entity).
+
+template <class...Ts>
+std::vector<std::byte> make_compression_dictionary(Ts const&...vals) {
+    auto dictionary = std::vector<std::byte>((0 + ... + serialized_size(vals)));
+    auto stream = throw_stream{ dictionary };
+    (stream << ... << vals);
+    return dictionary;
+}
+
+// The compression parameters of compressed<T, Config>. To change them, derive from it and
+// shadow the members :
+//   - threshold :     payloads smaller than 'threshold' bytes are not compressed.
+//   - dictionary() :  the dictionary used to compress and decompress payloads.
+
+struct default_compression {
+    static constexpr int threshold = 512;
+
+    static array_view<std::byte> dictionary() noexcept { return {}; }
+};
+
+// compressed<T> is serialized as T, compressed when it's serialized size reaches the threshold :
+//
+//   - varint (payload size << 1 | is compressed)
+//   - varint  raw size, if compressed
+//   - payload
+//
+// Below the threshold, or if compression does not shrink the payload, it costs the first varint.
+// Above it, the value is compressed each time it's serialized, in the context of the call (eg. the
+// current interning_scope) : use 'encode' to compress it once and send the bytes to several peers.
+// T must not hold views : they would outlive the decompressed bytes.
+
+template <class T, class Config = default_compression>
+class compressed {
+    T value_;
+
+public:
+    compressed() = default;
+
+    compressed(T value) :
+        value_{ std::move(value) } {}
+
+    T const& get() const noexcept { return value_; }
+    T&       get()       noexcept { return value_; }
+
+    T const& operator*() const noexcept { return get(); }
+    T&       operator*()       noexcept { return get(); }
+
+    T const* operator->() const noexcept { return &get(); }
+    T*       operator->()       noexcept { return &get(); }
+
+    // Replaces 'bytes' with the serialized bytes of this object.
+    void encode(std::vector<std::byte>& bytes) const;
+};
+
+template <class T, class Config>
+bool operator==(compressed<T, Config> const& lhs, compressed<T, Config> const& rhs) {
+    return lhs.get() == rhs.get();
+}
+
+namespace detail {
+    using compression_header_encoding = count_encoding::varint;
+
+    // The buffer holding the raw payloads of compressed<T>, one per thread and type.
+    template <class T>
+    std::vector<std::byte>& compression_buffer() {
+        static thread_local std::vector<std::byte> buffer;
+        return buffer;
+    }
+
+    // The buffer holding the encoded bytes of compressed<T>, one per thread and type.
+    template <class T>
+    std::vector<std::byte>& encoding_buffer() {
+        static thread_local std::vector<std::byte> buffer;
+        return buffer;
+    }
+
+    // Reads the header of a compressed<T>, without advancing 'span'.
+    // Returns it's size, or invalid_serialized_size if the span cannot contain the object.
+    inline int read_compression_header(buffer_span const& span, size_t& payload_size,
+                                       size_t& raw_size, bool& is_compressed) noexcept {
+        size_t header;
+        int size = serialized_count_size(span, header, compression_header_encoding{});
+        if (size == invalid_serialized_size) return invalid_serialized_size;
+
+        payload_size  = header >> 1;
+        is_compressed = header & 1;
+        raw_size      = payload_size;
+        if (is_compressed) {
+            int const raw_size_size = serialized_count_size(
+                buffer_span{ span.begin + size, span.end }, raw_size, compression_header_encoding{});
+            if (raw_size_size == invalid_serialized_size) return invalid_serialized_size;
+            size += raw_size_size;
+        }
+        if (payload_size > static_cast<size_t>(span.size() - size)) return invalid_serialized_size;
+        return size;
+    }
+
+    // Deserializes 'val' from exactly 'size' bytes.
+    template <class T>
+    bool try_deserialize_exactly(std::byte* const data, size_t const size, T& val) {
+        auto span = buffer_span{ data, data + size };
+        return try_deserialize(span, val) && span.is_empty();
+    }
+}
+
+template <class T, class Config>
+void compressed<T, Config>::encode(std::vector<std::byte>& bytes) const {
+    using encoding = detail::compression_header_encoding;
+
+    int const raw_size = serialized_size(value_);
+    int const max_header_size = 2 * serialized_count_size(max_serialized_count<encoding>, encoding{});
+    bytes.resize(max_header_size + std::max(raw_size, lz::max_compressed_size(raw_size)));
+    auto span = buffer_span{ bytes.data(), bytes.data() + bytes.size() };
+
+    int compressed_size = raw_size;
+    if (raw_size >= Config::threshold) {
+        auto& raw = detail::compression_buffer<T>();
+        raw.resize(raw_size);
+        auto raw_span = buffer_span{ raw.data(), raw.data() + raw_size };
+        serialize(raw_span, value_);
+
+        auto const payload = bytes.data() + max_header_size;
+        compressed_size = lz::compress(array_view<std::byte>{ raw }, payload, Config::dictionary());
+        if (compressed_size < raw_size) {
+            serialize_count(span, static_cast<size_t>(compressed_size) << 1 | 1, encoding{});
+            serialize_count(span, raw_size, encoding{});
+            memmove(span.begin, payload, compressed_size);
+            span.begin += compressed_size;
+        }
+    }
+    if (compressed_size >= raw_size) {
+        serialize_count(span, static_cast<size_t>(raw_size) << 1, encoding{});
+        serialize(span, value_);
+    }
+
+    bytes.resize(span.begin - bytes.data());
+}
+
+// Implementation for compressed<T, Config>.
+// Payloads below the threshold are serialized directly. Above it, they are encoded in a
+// per-thread buffer on each call : custom_try_serialize checks the encoded size, so checked
+// streams compress only once.
+
+namespace detail {
+    template <class T, class Config>
+    std::vector<std::byte> const& encode(compressed<T, Config> const& val) {
+        auto& bytes = encoding_buffer<T>();
+        val.encode(bytes);
+        return bytes;
+    }
+}
+
+template <class T, class Config>
+int custom_serialized_size(compressed<T, Config> const& val) {
+    int const raw_size = serialized_size(val.get());
+    if (raw_size < Config::threshold) return serialized_count_size(
+        static_cast<size_t>(raw_size) << 1, detail::compression_header_encoding{}) + raw_size;
+    return static_cast<int>(detail::encode(val).size());
+}
+
+template <class T, class Config>
+int custom_serialized_size(buffer_span const& span, type_tag<compressed<T, Config>>) noexcept {
+    size_t payload_size, raw_size;
+    bool is_compressed;
+    int const header_size = detail::read_compression_header(span, payload_size, raw_size, is_compressed);
+    if (header_size == invalid_serialized_size) return invalid_serialized_size;
+    return header_size + static_cast<int>(payload_size);
+}
+
+template <class T, class Config>
+void custom_serialize(buffer_span& span, compressed<T, Config> const& val) {
+    int const raw_size = serialized_size(val.get());
+    if (raw_size < Config::threshold) {
+        serialize_count(span, static_cast<size_t>(raw_size) << 1, detail::compression_header_encoding{});
+        serialize(span, val.get());
+    }
+    else {
+        auto const& encoded = detail::encode(val);
+        memcpy(span.begin, encoded.data(), encoded.size());
+        span.begin += encoded.size();
+    }
+}
+
+template <class T, class Config>
+bool custom_try_serialize(buffer_span& span, compressed<T, Config> const& val) {
+    int const raw_size = serialized_size(val.get());
+    if (raw_size < Config::threshold) {
+        int const header_size = serialized_count_size(
+            static_cast<size_t>(raw_size) << 1, detail::compression_header_encoding{});
+        if (span.size() < header_size + raw_size) return false;
+        serialize_count(span, static_cast<size_t>(raw_size) << 1, detail::compression_header_encoding{});
+        serialize(span, val.get());
+    }
+    else {
+        auto const& encoded = detail::encode(val);
+        if (static_cast<size_t>(span.size()) < encoded.size()) return false;
+        memcpy(span.begin, encoded.data(), encoded.size());
+        span.begin += encoded.size();
+    }
+    return true;
+}
+
+template <class T, class Config>
+bool custom_try_deserialize(buffer_span& span, compressed<T, Config>& val) {
+    size_t payload_size, raw_size;
+    bool is_compressed;
+    int const header_size = detail::read_compression_header(span, payload_size, raw_size, is_compressed);
+    if (header_size == invalid_serialized_size) return false;
+
+    auto const payload = span.begin + header_size;
+    if (!is_compressed) {
+        if (!detail::try_deserialize_exactly(payload, payload_size, val.get())) return false;
+    }
+    else {
+        // The raw size comes from the network : a payload can't expand more than 255 times.
+        if (raw_size > payload_size * 255 + 16) return false;
+
+        auto& raw = detail::compression_buffer<T>();
+        raw.resize(raw_size);
+        if (!lz::decompress(array_view<std::byte>{ payload, payload_size },
+                            raw.data(), static_cast<int>(raw_size), Config::dictionary()))
+            return false;
+        if (!detail::try_deserialize_exactly(raw.data(), raw_size, val.get())) return false;
+    }
+    span.begin = payload + payload_size;
+    return true;
+}
+
+template <class T, class Config>
+void custom_deserialize(buffer_span& span, compressed<T, Config>& val) {
+    [[maybe_unused]] bool const valid = custom_try_deserialize(span, val);
+    NABU_ASSERT(valid, "Tried to deserialize an invalid compressed payload");
+}
+
+} // nabu
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <serialization.hpp>
+#include <allocators.hpp>
+#include <memory>
+#include <vector>
+
+
+namespace nabu {
+
+// The growing stream serializes objects in blocks taken from a block_allocator_resource,
+// adding blocks while it serializes : there is no need to compute the serialized size first.
+// Each object is written contiguously, so an object which does not fit in the remaining space
+// of the last block starts a new block. Objects larger than a block have their own allocation,
+// and the last block stays available for the next objects.
+//
+// Objects of static size are written in a single pass. Others are first tried in the remaining
+// space, which stops at it's end : if they don't fit, they are sized then written.
+//
+// The written bytes are exposed as a list of contiguous segments, ready for scatter-gather IO.
+
+using growing_stream_resource_type = block_allocator_resource<1024>;
+
+template <class Resource = growing_stream_resource_type>
+class growing_stream {
+    Resource& resource_;
+    std::vector<void*> blocks_;
+    std::vector<std::unique_ptr<std::byte[]>> large_blocks_;
+    std::vector<buffer_span> segments_;
+    buffer_span free_;
+    int size_;
+
+    void add_block() {
+        auto const block = static_cast<std::byte*>(resource_.allocate());
+        blocks_.push_back(block);
+        free_ = { block, block + Resource::block_size };
+    }
+
+    void add_written(std::byte* const begin, std::byte* const end) {
+        if (begin == end) return;
+        if (segments_.empty() || segments_.back().end != begin)
+             segments_.push_back({ begin, end });
+        else segments_.back().end = end;
+        size_ += end - begin;
+    }
+
+    template <class T>
+    bool try_write(T const& val) {
+        auto const begin = free_.begin;
+        if (!try_serialize(free_, val)) return false;
+        add_written(begin, free_.begin);
+        return true;
+    }
+
+    // 'val' must fit in the remaining space.
+    template <class T>
+    void write(T const& val) {
+        auto const begin = free_.begin;
+        serialize(free_, val);
+        add_written(begin, free_.begin);
+    }
+
+    // Writes 'val' of serialized size 'size', which does not fit in the remaining space.
+    template <class T>
+    void write_new(T const& val, int const size) {
+        if (size > static_cast<int>(Resource::block_size)) return write_large(val, size);
+        add_block();
+        write(val);
+    }
+
+    template <class T>
+    void write_large(T const& val, int const size) {
+        auto& block = large_blocks_.emplace_back(std::make_unique<std::byte[]>(size));
+        auto span = buffer_span{ block.get(), block.get() + size };
+        serialize(span, val);
+        add_written(block.get(), span.begin);
+    }
+public:
+    explicit growing_stream(Resource& resource) noexcept :
+        resource_{ resource },
+        free_    { nullptr, nullptr },
+        size_    { 0 }
+    {}
+
+    ~growing_stream() {
+        clear();
+    }
+
+    growing_stream(growing_stream const&) = delete;
+    growing_stream& operator=(growing_stream const&) = delete;
+
+    template <class T>
+    growing_stream& operator<<(T const& val) {
+        if constexpr (has_static_serialized_size<T>) {
+            constexpr int size = static_serialized_size<T>;
+            if (free_.size() < size) write_new(val, size);
+            else write(val);
+        }
+        else if (!try_write(val)) write_new(val, serialized_size(val));
+        return *this;
+    }
+
+    // The written bytes, in order.
+    std::vector<buffer_span> const& segments() const noexcept { return segments_; }
+
+    // The number of bytes written.
+    int size() const noexcept { return size_; }
+
+    // Gives the blocks back to the resource.
+    void clear() noexcept {
+        for (auto const block : blocks_) resource_.deallocate(block);
+        blocks_.clear();
+        large_blocks_.clear();
+        segments_.clear();
+        free_ = { nullptr, nullptr };
+        size_ = 0;
+    }
+};
+
+} // nabu
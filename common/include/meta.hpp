@@ -96,8 +96,20 @@ constexpr bool is_iterable<T, std::void_t<decltype(
     std::end(std::declval<T const&>())
 )>> = true;
 
+// iterable_type<T> is the type of the elements of T. Proxies to the elements (eg. of
+// std::vector<bool>) are replaced by the value read through a const iterable.
+
+namespace detail {
+    template <class T>
+    using reference_of = decltype(*std::begin(std::declval<T&>()));
+}
+
 template <class T>
-using iterable_type = std::remove_reference_t<decltype(*std::begin(std::declval<T&>()))>;
+using iterable_type = std::conditional_t<
+    std::is_reference_v<detail::reference_of<T>>,
+    std::remove_reference_t<detail::reference_of<T>>,
+    std::decay_t<detail::reference_of<T const>>
+>;
 
 // is_continuous_iterable check std::data(t) and std::size(t) existence.
 
@@ -128,6 +140,23 @@ void reserve(T& val, size_t nb) {
     }
 }
 
+// clear(t) calls t.clear() if it exists, or assigns a default constructed value.
+
+namespace detail {
+    template <class T>
+    using clear_expression = decltype(std::declval<T&>().clear());
+}
+
+template <class T>
+void clear(T& val) {
+    if constexpr (is_detected<detail::clear_expression, T>) {
+        val.clear();
+    }
+    else {
+        val = T{};
+    }
+}
+
 // resize(t, nb) calls t.resize(nb).
 
 namespace detail {
@@ -169,16 +198,48 @@ decltype(auto) emplace(T& data, Args&&...args) {
     }
 }
 
+// emplace_sorted(t, val) emplaces val at the end of t if it's an ordered associative container,
+// which takes amortized constant time when val is not less than the last element, or calls
+// emplace(t, val) otherwise.
+
+namespace detail {
+    template <class T>
+    using key_comp_expression = decltype(std::declval<T&>().key_comp());
+}
+
+template <class T>
+constexpr bool is_ordered_associative = is_detected<detail::key_comp_expression, T>;
+
+template <class T, class...Args>
+decltype(auto) emplace_sorted(T& data, Args&&...args) {
+    if constexpr (is_ordered_associative<T>) {
+        return data.emplace_hint(data.end(), std::forward<Args>(args)...);
+    }
+    else {
+        return emplace(data, std::forward<Args>(args)...);
+    }
+}
+
+// overloaded{ fs... } is callable with the overloads of each 'fs'.
+
+template <class...Fs>
+struct overloaded : Fs... {
+    using Fs::operator()...;
+};
+
+template <class...Fs>
+overloaded(Fs...) -> overloaded<Fs...>;
+
 // for_each(tuple, f) applies f to each member of the tuple.
 
 template <class...Ts, class F>
 void for_each(std::tuple<Ts...>& tuple, F&& f) {
-    (..., f(std::get<Ts>(tuple)));
+    std::apply([&f] (auto&...vals) { (..., f(vals)); }, tuple);
 }
 
 template <class...Ts, class F>
 void for_each(std::tuple<Ts...> const& tuple, F&& f) {
-    (..., f(std::get<Ts>(tuple)));
+    std::apply([&f] (auto const&...vals) { (..., f(vals)); }, tuple);
 }
 
 // Removes constness of values, references, pairs and tuples.
@@ -235,7 +296,7 @@ namespace detail {
 }
 
 template <class F>
-using first_arg_of = detail::first_arg_of_t<F>::value;
+using first_arg_of = typename detail::first_arg_of_t<F>::type;
 
 // return_of<F> indicates the return argument of F.
 
@@ -1,7 +1,8 @@
-
 #pragma once
 
 #include <serialization.hpp>
+#include <growing_stream.hpp>
+#include <serialization_stats.hpp>
 #include <reflection.hpp>
 #include <boost/callable_traits/args.hpp>
 #include <function2.hpp>
@@ -10,12 +11,58 @@
 
 namespace nabu::msg {
 
+// Messages are framed by a header holding their id and payload size, so the receiver checks
+// the bounds once, and skips the messages it has no callback for :
+//
+//   framing::length_prefixed : [id : 1 byte][payload size : 4 bytes][payload]
+//   framing::tokens :          '{' [id] ':' [payload] '}'
+//
+// The token framing is kept for debugging, as frames are easy to spot in a dump.
+
+enum class framing {
+    length_prefixed,
+    tokens
+};
+
 struct parser_tokens {
     char begin;
     char separator;
     char end;
 };
 
+// The header is serialized field by field : as a trivial type, it would have the packed
+// layout (because of the padding after the id), reported by NABU_REPORT_PADDING.
+
+struct frame_header {
+    id_type id;
+    uint32_t size;
+};
+
+constexpr int custom_static_serialized_size(type_tag<frame_header>) noexcept {
+    return sizeof(id_type) + sizeof(uint32_t);
+}
+
+constexpr int custom_serialized_size(frame_header const&) noexcept {
+    return custom_static_serialized_size(type_tag<frame_header>{});
+}
+
+inline int custom_serialized_size(buffer_span const& span, type_tag<frame_header> tag) noexcept {
+    int const size = custom_static_serialized_size(tag);
+    return span.size() >= size ? size : invalid_serialized_size;
+}
+
+inline void custom_serialize(buffer_span& span, frame_header const& header) {
+    serialize(span, header.id);
+    serialize(span, header.size);
+}
+
+inline void custom_deserialize(buffer_span& span, frame_header& header) {
+    deserialize(span, header.id);
+    deserialize(span, header.size);
+}
+
+constexpr int frame_header_size = static_serialized_size<frame_header>;
+
 class parser_error : public std::runtime_error {
 public:
     inline explicit parser_error(std::string const& str) :
@@ -29,66 +76,202 @@ public:
         )} {}
 };
 
+namespace detail {
+    // The payload size is written once the payload is.
+    inline void write_frame_size(std::byte* const header, int const size) noexcept {
+        auto const wire = to_little_endian(static_cast<uint32_t>(size));
+        memcpy(header + sizeof(id_type), &wire, sizeof(wire));
+    }
+
+    template <class Message, class Stream>
+    void serialize_tokens(Stream& stream, Message const& msg, parser_tokens const& tokens) {
+        stream << tokens.begin
+               << id_of<Message>()
+               << tokens.separator
+               << msg
+               << tokens.end;
+    }
+
+    template <class Message, class Policy>
+    void serialize_frame(basic_stream<Policy>& stream, Message const& msg, framing const mode, parser_tokens const& tokens) {
+        static_assert(has_id<Message> && is_serializable<Message>);
+        record_serialization(msg);
+        if (mode == framing::tokens) return serialize_tokens(stream, msg, tokens);
+
+        auto const header = stream.begin;
+        stream << frame_header{ id_of<Message>(), 0 } << msg;
+        if constexpr (std::is_same_v<Policy, stream_policy::checked>) {
+            if (stream.error) return;
+        }
+        write_frame_size(header, static_cast<int>(stream.begin - header) - frame_header_size);
+    }
+
+    // Each object is written contiguously in a growing stream, so is the header.
+    template <class Message, class Resource>
+    void serialize_frame(growing_stream<Resource>& stream, Message const& msg, framing const mode, parser_tokens const& tokens) {
+        static_assert(has_id<Message> && is_serializable<Message>);
+        record_serialization(msg);
+        if (mode == framing::tokens) return serialize_tokens(stream, msg, tokens);
+
+        stream << frame_header{ id_of<Message>(), 0 };
+        auto const header = stream.segments().back().end - frame_header_size;
+        int const begin = stream.size();
+        stream << msg;
+        write_frame_size(header, stream.size() - begin);
+    }
+
+    inline void check_id(id_type const id) {
+        if (!is_valid_id(id)) throw parser_error
+            { "message id", fmt::format("value in [{}, {}]", id_min_value, id_max_value), id };
+    }
+
+    // With the token framing, the payload size is found by 'payload_size(id, span)', which
+    // returns the serialized size of the message 'id' in 'span' and throws for unknown ids.
+
+    template <class PayloadSize>
+    int frame_size(buffer_span const& span, framing const mode, parser_tokens const& tokens, PayloadSize const& payload_size) {
+        if (mode == framing::tokens) {
+            if (span.size() < 3) return invalid_serialized_size;
+            if (static_cast<char>(span.begin[0]) != tokens.begin ||
+                static_cast<char>(span.begin[2]) != tokens.separator) throw parser_error
+                { "invalid message tokens" };
+            auto const id = static_cast<id_type>(span.begin[1]);
+            check_id(id);
+
+            int const size = payload_size(id, buffer_span{ span.begin + 3, span.end });
+            if (size == invalid_serialized_size || size + 4 > span.size()) return invalid_serialized_size;
+            return size + 4;
+        }
+
+        auto s = span;
+        frame_header header;
+        if (!try_deserialize(s, header)) return invalid_serialized_size;
+        check_id(header.id);
+        if (header.size > static_cast<uint32_t>(s.size())) return invalid_serialized_size;
+        return frame_header_size + static_cast<int>(header.size);
+    }
+
+    // Reads one frame, and returns it's payload.
+    template <class Policy, class PayloadSize>
+    buffer_span read_frame(basic_stream<Policy>& stream, id_type& id, framing const mode,
+                           parser_tokens const& tokens, PayloadSize const& payload_size) {
+        if (mode == framing::tokens) {
+            char token;
+            stream >> token;
+            if (token != tokens.begin) throw parser_error
+                { "message begin token", tokens.begin, token };
+
+            stream >> id;
+            check_id(id);
+
+            stream >> token;
+            if (token != tokens.separator) throw parser_error
+                { "message separator token", tokens.separator, token };
+
+            // The payload is followed by the end token.
+            int const size = payload_size(id, stream);
+            if (size == invalid_serialized_size || size >= stream.size()) throw parser_error
+                { fmt::format("truncated message of id '{}'", id) };
+
+            auto const payload = buffer_span{ stream.begin, stream.begin + size };
+            stream.begin += size;
+            stream >> token;
+            if (token != tokens.end) throw parser_error
+                { "message end token", tokens.end, token };
+            return payload;
+        }
+
+        frame_header header;
+        stream >> header;
+        if (header.size > static_cast<uint32_t>(stream.size())) throw parser_error
+            { fmt::format("truncated message of id '{}' : {} bytes expected but {} received",
+                header.id, header.size, stream.size()) };
+        id = header.id;
+        check_id(id);
+
+        auto const payload = buffer_span{ stream.begin, stream.begin + header.size };
+        stream.begin += header.size;
+        return payload;
+    }
+
+    // Deserializes the whole payload into 'msg'.
+    template <class Message>
+    void deserialize_payload(buffer_span& payload, Message& msg) {
+        throw_deserialize(payload, msg);
+        if (!payload.is_empty()) throw parser_error { fmt::format(
+            "message of type '{}' is {} bytes shorter than it's frame", name_of<Message>(), payload.size()) };
+    }
+}
+
 class parser {
     using callback_t = fu2::unique_function<void(buffer_span&)>;
+    using size_function_t = int(*)(buffer_span const&) noexcept;
 
+    framing framing_;
     parser_tokens tokens_;
     std::vector<callback_t> callbacks_;
+    std::vector<size_function_t> size_functions_;
+
+    int payload_size(id_type const id, buffer_span const& span) const {
+        if (!size_functions_[id]) throw parser_error { fmt::format(
+            "invalid message id : no callback for id '{}'", id) };
+        return size_functions_[id](span);
+    }
 public:
-    inline explicit parser(parser_tokens tokens = { '{', ':', '}' }) :
-        tokens_{ tokens }, callbacks_(id_max_value + 1) {}
-    
-    template <class Message, class Policy>
-    void serialize(basic_stream<Policy>& stream, Message const& msg) {
-        static_assert(has_id<Message> && is_serializable<Message>);
+    inline explicit parser(framing mode = framing::length_prefixed, parser_tokens tokens = { '{', ':', '}' }) :
+        framing_{ mode }, tokens_{ tokens }, callbacks_(id_max_value + 1), size_functions_(id_max_value + 1) {}
 
-        stream << tokens_.begin
-               << id_of<Message>()
-               << tokens_.separator
-               << msg
-               << tokens_.end;
+    // 'Stream' is a basic_stream<Policy> or a growing_stream<Resource>.
+    template <class Message, class Stream>
+    void serialize(Stream& stream, Message const& msg) {
+        detail::serialize_frame(stream, msg, framing_, tokens_);
+    }
+
+    // Returns the size of the frame at the beginning of 'span', or invalid_serialized_size if
+    // it's not complete yet. Throws a parser_error if the frame is invalid. With the token
+    // framing, the message id must have a callback.
+    int frame_size(buffer_span const& span) const {
+        return detail::frame_size(span, framing_, tokens_, [this] (id_type const message_id, buffer_span const& s) {
+            return payload_size(message_id, s);
+        });
     }
 
+    // Reads one frame, and calls the callback of it's message id.
+    // With the length prefixed framing, messages without callback are skipped : returns false
+    // in this case, as their interned strings are not registered (see interning_scope).
     template <class Policy>
-    void deserialize(basic_stream<Policy>& stream) {
-        char token;
-        stream >> token;
-        if (token != tokens_.begin) throw parser_error
-            { "message begin token", tokens_.begin, token };
-                
+    bool deserialize(basic_stream<Policy>& stream) {
         id_type id;
-        stream >> id;
-        if (!is_valid_id(id)) throw parser_error
-            { "message id", fmt::format("value in [{}, {}]", id_min_value, id_max_value), id };
-        
-        auto& f = callbacks_[id];
-        if (!f) throw parser_error { fmt::format(
-            "invalid message id : no callback for id '{}'", id) };
-
-        stream >> token;
-        if (token != tokens_.separator) throw parser_error
-            { "message separator token", tokens_.separator, token };
-        
-        f(stream);
+        auto payload = detail::read_frame(stream, id, framing_, tokens_, [this] (id_type const message_id, buffer_span const& s) {
+            return payload_size(message_id, s);
+        });
+        if (!callbacks_[id]) return false;
+        callbacks_[id](payload);
+        return true;
     }
 
+    // The message is deserialized in the received buffer : if it holds views
+    // (eg. std::string_view), they are only valid during the callback.
+    // The callback can take the message by value, reference or rvalue reference.
+    // One message instance is kept per id and deserialized into, so it's storage is
+    // reused between messages unless the callback moves from it.
     template <class F>
     void set_callback(F&& f) {
-        using Message = std::remove_reference_t<first_arg_of<F>>;
+        using Message = std::remove_cv_t<std::remove_reference_t<first_arg_of<F>>>;
         static_assert(has_id<Message> && is_serializable<Message>,
             "The callback [F] argument must validates 'had_id' and 'is_serializable'");
-        
+
         auto const id = id_of<Message>();
 
-        callbacks_[id] = [this, f = std::forward<F>(f)] (buffer_span& span) {
-            Message msg;
-            throw_deserialize(span, msg);
-            char token;
-            throw_deserialize(span, token);
-            if (token != tokens_.end) throw parser_error
-                { "message separator token", tokens_.end, token };
-            
-            f(std::move(msg));
+        size_functions_[id] = [] (buffer_span const& span) noexcept {
+            return serialized_size(span, type_tag<Message>{});
+        };
+        callbacks_[id] = [f = std::forward<F>(f), msg = Message{}] (buffer_span& payload) mutable {
+            detail::deserialize_payload(payload, msg);
+
+            if constexpr (std::is_lvalue_reference_v<first_arg_of<F>>)
+                 f(msg);
+            else f(std::move(msg));
         };
     }
 };
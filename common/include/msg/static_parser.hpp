@@ -0,0 +1,120 @@
+#pragma once
+
+#include <msg/parser.hpp>
+#include <array>
+#include <tuple>
+
+
+namespace nabu::msg {
+
+namespace detail {
+    template <class...Messages>
+    constexpr bool has_unique_ids() {
+        id_type const ids[] = { id_of<Messages>()... };
+        for (size_t i = 0; i < sizeof...(Messages); ++i)
+            for (size_t j = i + 1; j < sizeof...(Messages); ++j)
+                if (ids[i] == ids[j]) return false;
+        return true;
+    }
+}
+
+// static_parser<Messages...> reads and writes the same frames as parser, but it knows the
+// message types at compile time : the id indexes a constexpr table of per message decoders,
+// which call the handler directly so it can be inlined. One instance of each message is kept
+// and deserialized into.
+//
+//   auto parser = static_parser<login_request, chat>{};
+//   parser.deserialize(stream, overloaded{
+//       [] (login_request& msg) { ... },
+//       [] (chat& msg) { ... }
+//   });
+//
+// The handler must be callable with a reference to each message. With the length prefixed
+// framing, other ids are skipped. Use parser for messages registered at runtime (plugins).
+
+template <class...Messages>
+class static_parser {
+    static_assert(sizeof...(Messages) > 0, "[Messages] must not be empty");
+    static_assert((... && (has_id<Messages> && is_serializable<Messages>)),
+        "[Messages] must validate 'has_id' and 'is_serializable'");
+
+    static_assert(detail::has_unique_ids<Messages...>(), "[Messages] must have different ids");
+
+    framing framing_;
+    parser_tokens tokens_;
+    std::tuple<Messages...> messages_;
+
+    // The tables are indexed by id, which read_frame checks to be in [id_min_value, id_max_value].
+    // The ids without message have null entries.
+
+    using size_function_t = int(*)(buffer_span const&) noexcept;
+
+    template <class Message>
+    static int payload_size_of(buffer_span const& span) noexcept {
+        return serialized_size(span, type_tag<Message>{});
+    }
+
+    static constexpr std::array<size_function_t, id_max_value + 1> size_functions() {
+        auto table = std::array<size_function_t, id_max_value + 1>{};
+        (..., (table[id_of<Messages>()] = &payload_size_of<Messages>));
+        return table;
+    }
+
+    static constexpr auto size_functions_ = size_functions();
+
+    static int payload_size(id_type const id, buffer_span const& span) {
+        if (!size_functions_[id]) throw parser_error { fmt::format(
+            "invalid message id : no message type for id '{}'", id) };
+        return size_functions_[id](span);
+    }
+
+    template <class Handler>
+    using decoder_t = void(*)(static_parser&, buffer_span&, Handler&);
+
+    template <class Message, class Handler>
+    static void decode(static_parser& self, buffer_span& payload, Handler& handler) {
+        auto& msg = std::get<Message>(self.messages_);
+        detail::deserialize_payload(payload, msg);
+        handler(msg);
+    }
+
+    template <class Handler>
+    static constexpr std::array<decoder_t<Handler>, id_max_value + 1> decoders() {
+        auto table = std::array<decoder_t<Handler>, id_max_value + 1>{};
+        (..., (table[id_of<Messages>()] = &decode<Messages, Handler>));
+        return table;
+    }
+
+    template <class Handler>
+    static constexpr auto decoders_ = decoders<Handler>();
+public:
+    explicit static_parser(framing mode = framing::length_prefixed, parser_tokens tokens = { '{', ':', '}' }) :
+        framing_{ mode }, tokens_{ tokens } {}
+
+    // 'Stream' is a basic_stream<Policy> or a growing_stream<Resource>.
+    template <class Message, class Stream>
+    void serialize(Stream& stream, Message const& msg) {
+        static_assert((... || std::is_same_v<Message, Messages>), "[Message] is not in [Messages]");
+        detail::serialize_frame(stream, msg, framing_, tokens_);
+    }
+
+    // Like parser::frame_size.
+    int frame_size(buffer_span const& span) const {
+        return detail::frame_size(span, framing_, tokens_, &payload_size);
+    }
+
+    // Reads one frame, and calls 'handler' with it's message. The message is deserialized in
+    // the received buffer : if it holds views, they are only valid during the call.
+    template <class Policy, class Handler>
+    void deserialize(basic_stream<Policy>& stream, Handler&& handler) {
+        static_assert((... && std::is_invocable_v<Handler&, Messages&>),
+            "[Handler] must be callable with a reference to each message");
+
+        id_type id;
+        auto payload = detail::read_frame(stream, id, framing_, tokens_, &payload_size);
+        if (auto const decode = decoders_<std::remove_reference_t<Handler>>[id])
+            decode(*this, payload, handler);
+    }
+};
+
+} // nabu::msg
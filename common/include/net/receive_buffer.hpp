@@ -0,0 +1,90 @@
+#pragma once
+
+#include <serialization.hpp>
+#include <memory>
+
+
+namespace nabu::net {
+
+// receive_buffer keeps the received bytes of a connection until they form complete frames,
+// which are parsed in place. It's a ring buffer whose frames are always contiguous : when
+// the free space at the end runs low, the unread bytes (an incomplete frame) are moved to
+// the front instead of wrapping around. It doubles when an incomplete frame fills half of it,
+// up to 'max_size'.
+//
+//   auto free = buffer.prepare();          // receive up to free.size() bytes in free.begin
+//   buffer.commit(received);
+//   auto frames = buffer.data();           // parse complete frames
+//   buffer.consume(parsed);
+
+class receive_buffer {
+    std::unique_ptr<std::byte[]> data_;
+    size_t capacity_;
+    size_t max_size_;
+    size_t begin_;
+    size_t end_;
+
+    void compact() noexcept {
+        if (begin_ == 0) return;
+        memmove(data_.get(), data_.get() + begin_, end_ - begin_);
+        end_ -= begin_;
+        begin_ = 0;
+    }
+
+    void grow() {
+        auto const capacity = std::min(capacity_ * 2, max_size_);
+        auto data = std::make_unique<std::byte[]>(capacity);
+        memcpy(data.get(), data_.get() + begin_, end_ - begin_);
+        data_ = std::move(data);
+        capacity_ = capacity;
+        end_ -= begin_;
+        begin_ = 0;
+    }
+public:
+    static constexpr size_t default_size = 1 << 14;
+    static constexpr size_t default_max_size = 1 << 24;
+
+    explicit receive_buffer(size_t const capacity = default_size, size_t const max_size = default_max_size) :
+        data_    { std::make_unique<std::byte[]>(capacity) },
+        capacity_{ capacity },
+        max_size_{ std::max(capacity, max_size) },
+        begin_   { 0 },
+        end_     { 0 }
+    {}
+
+    // The free space to receive bytes into. It's empty when 'max_size' unread bytes are kept.
+    buffer_span prepare() {
+        if (begin_ == end_) begin_ = end_ = 0;
+        if (capacity_ - end_ < capacity_ / 2) {
+            compact();
+            if (capacity_ - end_ < capacity_ / 2 && capacity_ < max_size_) grow();
+        }
+        return { data_.get() + end_, data_.get() + capacity_ };
+    }
+
+    // Adds 'size' bytes received in the span returned by prepare.
+    void commit(size_t const size) noexcept {
+        NABU_ASSERT(size <= capacity_ - end_, "Tried to commit more bytes than prepared");
+        end_ += size;
+    }
+
+    // The unread bytes.
+    buffer_span data() noexcept {
+        return { data_.get() + begin_, data_.get() + end_ };
+    }
+
+    // Removes 'size' bytes read from the beginning of data.
+    void consume(size_t const size) noexcept {
+        NABU_ASSERT(size <= end_ - begin_, "Tried to consume more bytes than received");
+        begin_ += size;
+    }
+
+    void clear() noexcept {
+        begin_ = end_ = 0;
+    }
+
+    size_t size()     const noexcept { return end_ - begin_; }
+    size_t capacity() const noexcept { return capacity_; }
+};
+
+} // nabu::net
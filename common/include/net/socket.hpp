@@ -3,57 +3,141 @@
 
 #include <environment.hpp>
 #include <msg/parser.hpp>
+#include <net/receive_buffer.hpp>
+#include <SFML/Network/IpAddress.hpp>
 #include <SFML/Network/TcpSocket.hpp>
+#include <SFML/Network/SocketHandle.hpp>
+#include <array>
 #include <chrono>
 #include "logger.hpp"
 
 
 namespace nabu::net {
 
+namespace detail {
+    // Exposes the OS handle, for the gather writes.
+    class tcp_socket : public sf::TcpSocket {
+    public:
+        using sf::TcpSocket::getHandle;
+    };
+
+    // Writes the segments with one gather write (sendmsg, or WSASend on Windows). Returns the
+    // number of bytes written, 0 if the socket would block, or -1 if the connection failed.
+    std::ptrdiff_t write_segments(sf::SocketHandle handle, buffer_span const* segments, int count) noexcept;
+
+    constexpr int max_write_segments = 64;
+}
+
 class socket {
-    sf::TcpSocket socket_;
-	std::vector<std::byte> buffer_;
+    detail::tcp_socket socket_;
+	receive_buffer receive_buffer_;
+	growing_stream_resource_type send_resource_;
+	growing_stream<> send_stream_;
+	size_t sent_segments_;
+	size_t sent_bytes_;
+	string_table send_strings_;
+	string_table receive_strings_;
 	msg::parser parser_;
     std::chrono::steady_clock::time_point last_beat_;
     bool connected_;
 public:
     socket() :
-		buffer_(1024),
-		connected_{ false }
+		send_resource_{ 4 },
+		send_stream_  { send_resource_ },
+		sent_segments_{ 0 },
+		sent_bytes_   { 0 },
+		connected_    { false }
     {
 	    socket_.setBlocking(false);
     }
 
-	bool try_connect(sf::IpAddress const& ip, uint16_t const port) {
-		connected_ = socket_.connect(ip, port) == sf::Socket::Done;
+	// Without timeout, the connection attempt doesn't wait for the peer.
+	bool try_connect(sf::IpAddress const& ip, uint16_t const port, sf::Time const timeout = sf::Time::Zero) {
+		connected_ = socket_.connect(ip, port, timeout) == sf::Socket::Done;
+		receive_buffer_.clear();
+		clear_sent();
+		send_strings_.clear();
+		receive_strings_.clear();
 		return connected_;
     }
 
+	// Queues the message : the queued messages are sent together by flush.
 	template <class Message>
 	void send(Message const& msg) {
 		NABU_ASSERT(is_connected(), "Tried to send a {} while being not connected", name_of<Message>());
 
-		auto span = throw_stream{ buffer_ };
-		parser_.serialize(span, msg);
-		socket_.send(span.begin, span.size()); // TODO Check result
+		auto interning = interning_scope{ send_strings_ };
+		parser_.serialize(send_stream_, msg);
+		interning.commit();
+	}
+
+	// Writes the queued messages with gather writes, once per tick. If the kernel does not
+	// take all of them, the next call resumes where this one stopped.
+	void flush() {
+		NABU_ASSERT(is_connected(), "Tried to flush messages while being not connected");
+
+		auto const& segments = send_stream_.segments();
+		while (sent_segments_ < segments.size()) {
+			auto pending = std::array<buffer_span, detail::max_write_segments>{};
+			int count = 0;
+			for (auto i = sent_segments_; i < segments.size() && count < detail::max_write_segments; ++i)
+				pending[count++] = segments[i];
+			pending[0].begin += sent_bytes_;
+
+			auto written = detail::write_segments(socket_.getHandle(), pending.data(), count);
+			if (written < 0) {
+				logger.warning("Failed to send data to {}:{}", socket_.getRemoteAddress().toString(), socket_.getRemotePort());
+				return disconnect();
+			}
+			if (written == 0) return;
+
+			for (int i = 0; written > 0; ++i) {
+				auto const size = std::min<std::ptrdiff_t>(written, pending[i].size());
+				written -= size;
+				if (size == pending[i].size()) ++sent_segments_, sent_bytes_ = 0;
+				else sent_bytes_ += size;
+			}
+		}
+		clear_sent();
 	}
 
+	bool has_pending_sends() const noexcept { return send_stream_.size() > 0; }
+
+	// Receives the bytes the kernel has ready, and parses the complete frames in place after
+	// each read. Only an incomplete frame is kept until the next call, so the peer is disconnected
+	// only if a single message is larger than the maximum size of the receive buffer.
 	void receive_all() {
 		NABU_ASSERT(is_connected(), "Tried to receive messages while being not connected");
 
-		size_t received = 0;
-		socket_.receive(buffer_.data(), buffer_.size(), received); // TODO Check result
-		auto span = throw_stream{ buffer_.data(), received };
-		try {
-			while (!span.is_empty()) {
-				parser_.deserialize(span);
+		auto status = sf::Socket::Done;
+		while (status == sf::Socket::Done) {
+			auto const free = receive_buffer_.prepare();
+			if (free.is_empty()) {
+				logger.warning("While receiving data from socket : a message is larger than {} bytes", receive_buffer_.capacity());
+				return disconnect();
 			}
+
+			size_t received = 0;
+			status = socket_.receive(free.begin, free.size(), received);
+			receive_buffer_.commit(received);
+			if (!parse_frames()) return disconnect();
+			if (received < static_cast<size_t>(free.size())) break;
 		}
-		catch (std::runtime_error const& e) {
-			logger.warning("While receiving data from socket : {}", e.what());
+
+		if (status == sf::Socket::Disconnected || status == sf::Socket::Error) {
+			logger.info("Disconnected from {}:{}", socket_.getRemoteAddress().toString(), socket_.getRemotePort());
+			disconnect();
 		}
     }
 
+	void disconnect() {
+		socket_.disconnect();
+		clear_sent();
+		send_strings_.clear();
+		receive_strings_.clear();
+		connected_ = false;
+	}
+
 	template <class F>
 	void add_callback(F&& f)
     {
@@ -61,6 +145,47 @@ public:
     }
 
     bool is_connected() const noexcept { return connected_; }
+private:
+	// Parses and consumes the complete frames of the receive buffer.
+	// Returns false if a frame header is invalid, or if a frame is skipped or fails to
+	// deserialize : the receive table may then be behind the peer's (see interning_scope).
+	bool parse_frames() {
+		auto const data = receive_buffer_.data();
+		auto span = data;
+		while (true) {
+			// An invalid frame header leaves no way to find the next frame.
+			int size;
+			try { size = parser_.frame_size(span); }
+			catch (msg::parser_error const& e) {
+				logger.warning("While receiving data from socket : {}", e.what());
+				receive_buffer_.clear();
+				return false;
+			}
+			if (size == invalid_serialized_size) break;
+
+			auto frame = throw_stream{ span.begin, size };
+			span.begin += size;
+			try {
+				auto interning = interning_scope{ receive_strings_ };
+				if (!parser_.deserialize(frame)) throw msg::parser_error
+					{ "received a message without callback" };
+				interning.commit();
+			}
+			catch (std::runtime_error const& e) {
+				logger.warning("While receiving data from socket : {}", e.what());
+				receive_buffer_.clear();
+				return false;
+			}
+		}
+		receive_buffer_.consume(span.begin - data.begin);
+		return true;
+	}
+
+	void clear_sent() noexcept {
+		send_stream_.clear();
+		sent_segments_ = 0;
+		sent_bytes_ = 0;
+	}
 };
 
 } // nabu::net
@@ -2,6 +2,9 @@
 #pragma once
 
 #include <serialization_base.hpp>
+#include <serialization_views.hpp>
+#include <serialization_columnar.hpp>
+#include <serialization_interning.hpp>
 #include <optional>
 #include <variant>
 
@@ -12,7 +15,7 @@ namespace nabu {
 
 template <class T>
 constexpr int custom_serialized_size(std::optional<T> const& opt) noexcept {
-    return sizeof(bool) + opt ? serialized_size(*opt) : 0;
+    return sizeof(bool) + (opt ? serialized_size(*opt) : 0);
 }
 
 template <class T>
@@ -51,6 +54,26 @@ void custom_deserialize(buffer_span& span, std::optional<T>& opt) {
     else opt.reset();
 }
 
+template <class T>
+bool custom_try_serialize(buffer_span& span, std::optional<T> const& opt) {
+    auto has_val = opt.has_value();
+    if (!try_serialize(span, has_val)) return false;
+    return !has_val || try_serialize(span, *opt);
+}
+
+template <class T>
+bool custom_try_deserialize(buffer_span& span, std::optional<T>& opt) {
+    bool has_val;
+    if (!try_deserialize(span, has_val)) return false;
+    if (has_val) {
+        T v;
+        if (!try_deserialize(span, v)) return false;
+        opt = std::move(v);
+    }
+    else opt.reset();
+    return true;
+}
+
 // Implementation for std::pair<T1, T2>.
 
 template <class T1, class T2>
@@ -74,6 +97,13 @@ int custom_serialized_size(buffer_span const& span, type_tag<std::pair<T1, T2>>)
     return size_1 + size_2;
 }
 
+template <class T1, class T2>
+constexpr int custom_static_serialized_size(type_tag<std::pair<T1, T2>>) noexcept {
+    if constexpr (has_static_serialized_size<T1> && has_static_serialized_size<T2>)
+         return static_serialized_size<T1> + static_serialized_size<T2>;
+    else return dynamic_serialized_size;
+}
+
 template <class T1, class T2>
 void custom_serialize(buffer_span& span, std::pair<T1, T2> const& pair) {
     serialize(span, pair.first);
@@ -86,30 +116,134 @@ void custom_deserialize(buffer_span& span, std::pair<T1, T2>& pair) {
     deserialize(span, pair.second);
 }
 
+template <class T1, class T2>
+bool custom_try_serialize(buffer_span& span, std::pair<T1, T2> const& pair) {
+    return try_serialize(span, pair.first) && try_serialize(span, pair.second);
+}
+
+template <class T1, class T2>
+bool custom_try_deserialize(buffer_span& span, std::pair<T1, T2>& pair) {
+    return try_deserialize(span, pair.first) && try_deserialize(span, pair.second);
+}
+
 // Implementation for std::variant<Ts...>.
-/*
+// The alternative index is serialized first, with the smallest type able to hold it.
+// Deserialization dispatches on it with a table of per-alternative functions.
+
+namespace detail {
+    template <class...Ts>
+    using variant_index_t = std::conditional_t<(sizeof...(Ts) <= 0x100), uint8_t, uint16_t>;
+
+    template <class Variant, size_t I>
+    int variant_alternative_size(buffer_span const& span) noexcept {
+        return serialized_size(span, type_tag<std::variant_alternative_t<I, Variant>>{});
+    }
+
+    // The alternative is kept if it's already the active one, so it's storage is reused.
+    template <class Variant, size_t I>
+    void deserialize_variant_alternative(buffer_span& span, Variant& variant) {
+        if (variant.index() != I) variant.template emplace<I>();
+        deserialize(span, *std::get_if<I>(&variant));
+    }
+    template <class Variant, size_t I>
+    bool try_deserialize_variant_alternative(buffer_span& span, Variant& variant) {
+        if (variant.index() != I) variant.template emplace<I>();
+        return try_deserialize(span, *std::get_if<I>(&variant));
+    }
+
+    template <class Variant, class = std::make_index_sequence<std::variant_size_v<Variant>>>
+    struct variant_table;
+
+    template <class Variant, size_t...Is>
+    struct variant_table<Variant, std::index_sequence<Is...>> {
+        using size_function           = int  (*) (buffer_span const&) noexcept;
+        using deserialize_function    = void (*) (buffer_span&, Variant&);
+        using try_deserialize_function = bool (*) (buffer_span&, Variant&);
+
+        static constexpr size_function sizes[] = {
+            &variant_alternative_size<Variant, Is>... };
+        static constexpr deserialize_function deserializers[] = {
+            &deserialize_variant_alternative<Variant, Is>... };
+        static constexpr try_deserialize_function try_deserializers[] = {
+            &try_deserialize_variant_alternative<Variant, Is>... };
+    };
+}
+
 template <class...Ts>
-constexpr int custom_serialized_size(std::variant<Ts...> const& variant) noexcept {
-    if (variant.valueless_by_exception()) throw std::bad_variant_access{};
-    
+constexpr int custom_static_serialized_size(type_tag<std::variant<Ts...>>) noexcept {
+    constexpr int size = static_serialized_size<detail::variant_index_t<Ts...>>;
+    if constexpr ((true && ... && has_static_serialized_size<Ts>)) {
+        constexpr int sizes[] = { static_serialized_size<Ts>... };
+        for (int const s : sizes) {
+            if (s != sizes[0]) return dynamic_serialized_size;
+        }
+        return size + sizes[0];
+    }
+    else return dynamic_serialized_size;
 }
 
-template <class T1, class T2>
+template <class...Ts>
+int custom_serialized_size(std::variant<Ts...> const& variant) noexcept {
+    NABU_ASSERT(!variant.valueless_by_exception(), "Tried to serialize a valueless variant");
+    return sizeof(detail::variant_index_t<Ts...>) +
+        std::visit([] (auto const& v) { return serialized_size(v); }, variant);
+}
+
+template <class...Ts>
 int custom_serialized_size(buffer_span const& span, type_tag<std::variant<Ts...>>) noexcept {
-    if (variant.valueless_by_exception()) throw std::bad_variant_access{};
-    
+    using index_t = detail::variant_index_t<Ts...>;
+    if (span.size() < static_cast<int>(sizeof(index_t)))
+        return invalid_serialized_size;
+
+    auto s = span;
+    index_t index;
+    deserialize(s, index);
+    if (index >= sizeof...(Ts))
+        return invalid_serialized_size;
+
+    using table = detail::variant_table<std::variant<Ts...>>;
+    int const size = table::sizes[index](s);
+    if (size == invalid_serialized_size)
+        return invalid_serialized_size;
+
+    return sizeof(index_t) + size;
 }
 
-template <class T1, class T2>
+template <class...Ts>
 void custom_serialize(buffer_span& span, std::variant<Ts...> const& variant) {
-    if (variant.valueless_by_exception()) throw std::bad_variant_access{};
-    
+    NABU_ASSERT(!variant.valueless_by_exception(), "Tried to serialize a valueless variant");
+    serialize(span, static_cast<detail::variant_index_t<Ts...>>(variant.index()));
+    std::visit([&span] (auto const& v) { serialize(span, v); }, variant);
 }
 
-template <class T1, class T2>
+template <class...Ts>
+bool custom_try_serialize(buffer_span& span, std::variant<Ts...> const& variant) {
+    NABU_ASSERT(!variant.valueless_by_exception(), "Tried to serialize a valueless variant");
+    if (!try_serialize(span, static_cast<detail::variant_index_t<Ts...>>(variant.index())))
+        return false;
+    return std::visit([&span] (auto const& v) { return try_serialize(span, v); }, variant);
+}
+
+// The index comes from the received data : it's checked even by the unchecked deserialize,
+// as it selects the function called.
+
+template <class...Ts>
 void custom_deserialize(buffer_span& span, std::variant<Ts...>& variant) {
-    if (variant.valueless_by_exception()) throw std::bad_variant_access{};
-    
+    detail::variant_index_t<Ts...> index;
+    deserialize(span, index);
+    if (index >= sizeof...(Ts)) throw read_buffer_overflow{ fmt::format(
+        "Invalid alternative index {} for a variant of {} alternatives", index, sizeof...(Ts) )};
+    using table = detail::variant_table<std::variant<Ts...>>;
+    table::deserializers[index](span, variant);
 }
-*/
+
+template <class...Ts>
+bool custom_try_deserialize(buffer_span& span, std::variant<Ts...>& variant) {
+    detail::variant_index_t<Ts...> index;
+    if (!try_deserialize(span, index) || index >= sizeof...(Ts))
+        return false;
+    using table = detail::variant_table<std::variant<Ts...>>;
+    return table::try_deserializers[index](span, variant);
+}
+
 } // nabu
@@ -2,10 +2,12 @@
 #pragma once
 
 #include <meta.hpp>
+#include <byte_order.hpp>
 #include <environment.hpp>
 #include <reflection.hpp>
 #include <aggregates_to_tuples.hpp>
 #include <fmt/format.h>
+#include <algorithm>
 #include <limits>
 #include <cstring>
 #include <iterator>
@@ -125,19 +127,137 @@ public:
         std::runtime_error{ str } {}
 };
 
-// The type serialized to store the collections items count.
-// TODO serial_traits<T>::count_type.
+// Value returned when a span does not contain the serialized object.
 
-using serialized_count_t = uint16_t;
-constexpr size_t max_serialized_count = std::numeric_limits<serialized_count_t>::max();
+constexpr int invalid_serialized_size = -1;
+
+// Collections are prefixed with their items count. It's encoding is chosen per type
+// with serial_traits<T>::count_type, which is one of the following :
+//
+//   - count_encoding::varint :       LEB128, 1 byte below 128 items, 5 bytes at most (default).
+//   - count_encoding::fixed<Int> :   always sizeof(Int) bytes, with Int unsigned.
+//
+// serial_traits can be specialized by the user to change the encoding of a type.
+
+namespace count_encoding {
+    struct varint {};
+
+    template <class Integer>
+    struct fixed {
+        static_assert(std::is_unsigned_v<Integer>, "[Integer] must be an unsigned integer type");
+    };
+}
+
+using default_count_encoding = count_encoding::varint;
+
+template <class T, class SFINAE = void>
+struct serial_traits {
+    using count_type = default_count_encoding;
+};
+
+template <class T>
+using count_encoding_of = typename serial_traits<remove_deep_const<std::remove_reference_t<T>>>::count_type;
+
+// The maximum count which can be serialized with the given encoding.
+
+template <class Encoding>
+constexpr size_t max_serialized_count = 0;
+
+template <>
+constexpr size_t max_serialized_count<count_encoding::varint> = std::numeric_limits<uint32_t>::max();
+
+template <class Integer>
+constexpr size_t max_serialized_count<count_encoding::fixed<Integer>> = std::numeric_limits<Integer>::max();
+
+#define NABU_ASSERT_SERIALIZED_COUNT(count, Encoding) \
+    NABU_ASSERT(count <= ::nabu::max_serialized_count<Encoding>, \
+        "Can't serialize the count '{}' with the encoding '{}' (max value = {})", \
+        count, ::nabu::name_of<Encoding>(), ::nabu::max_serialized_count<Encoding>)
+
+// Returns the number of bytes needed to serialize the given count.
+
+constexpr int serialized_count_size(size_t count, count_encoding::varint) noexcept {
+    int size = 1;
+    while (count >= 0x80) {
+        count >>= 7;
+        ++size;
+    }
+    return size;
+}
+template <class Integer>
+constexpr int serialized_count_size(size_t, count_encoding::fixed<Integer>) noexcept {
+    return sizeof(Integer);
+}
+
+// Returns the number of bytes of the count stored in span, and writes it in 'count'.
+// If the span does not contain a valid count, it returns 'invalid_serialized_size'.
+
+inline int serialized_count_size(buffer_span const& span, size_t& count, count_encoding::varint) noexcept {
+    constexpr int max_size = 5;
+    int const size = span.size() < max_size ? span.size() : max_size;
+    count = 0;
+    for (int i = 0; i < size; ++i) {
+        auto const byte = std::to_integer<size_t>(span.begin[i]);
+        count |= (byte & 0x7F) << (7 * i);
+        if (byte < 0x80) {
+            return count <= max_serialized_count<count_encoding::varint> ? i + 1 : invalid_serialized_size;
+        }
+    }
+    return invalid_serialized_size;
+}
+template <class Integer>
+int serialized_count_size(buffer_span const& span, size_t& count, count_encoding::fixed<Integer>) noexcept {
+    if (span.size() < static_cast<int>(sizeof(Integer))) return invalid_serialized_size;
+    Integer value;
+    memcpy(&value, span.begin, sizeof(Integer));
+    count = from_little_endian(value);
+    return sizeof(Integer);
+}
+
+// Serialize 'count' into 'span', advancing 'span.begin'. The span is not checked.
 
-#define NABU_ASSERT_SERIALIZED_COUNT(count) \
-    NABU_ASSERT(count <= ::nabu::max_serialized_count, \
-        "Can't serialize the count '{}' in the type '{}' (max value = {})", \
-        count, ::nabu::name_of<serialized_count_t>(), max_serialized_count)
+inline void serialize_count(buffer_span& span, size_t count, count_encoding::varint) {
+    NABU_ASSERT_SERIALIZED_COUNT(count, count_encoding::varint);
+    while (count >= 0x80) {
+        *span.begin++ = static_cast<std::byte>(count | 0x80);
+        count >>= 7;
+    }
+    *span.begin++ = static_cast<std::byte>(count);
+}
+template <class Integer>
+void serialize_count(buffer_span& span, size_t const count, count_encoding::fixed<Integer>) {
+    NABU_ASSERT_SERIALIZED_COUNT(count, count_encoding::fixed<Integer>);
+    auto const value = to_little_endian(static_cast<Integer>(count));
+    memcpy(span.begin, &value, sizeof(Integer));
+    span.begin += sizeof(Integer);
+}
+
+// Deserialize a count from 'span', advancing 'span.begin'. The span is not checked.
+
+inline size_t deserialize_count(buffer_span& span, count_encoding::varint) noexcept {
+    size_t count = 0;
+    int shift = 0;
+    size_t byte;
+    do {
+        byte = std::to_integer<size_t>(*span.begin++);
+        count |= (byte & 0x7F) << shift;
+        shift += 7;
+    } while (byte >= 0x80);
+    return count;
+}
+template <class Integer>
+size_t deserialize_count(buffer_span& span, count_encoding::fixed<Integer>) noexcept {
+    Integer value;
+    memcpy(&value, span.begin, sizeof(Integer));
+    span.begin += sizeof(Integer);
+    return from_little_endian(value);
+}
 
 // Indicates if a type has custom serialization functions.
 // The user must define the tested functions below.
+// He can also define 'custom_try_deserialize(buffer_span&, T&) -> bool' to validate the span
+// while deserializing, instead of computing the serialized size first.
+// Likewise, 'custom_try_serialize(buffer_span&, T const&) -> bool' checks the span while serializing.
 
 template <class T, class SFINAE = void>
 constexpr bool is_custom_serializable = false;
@@ -150,14 +270,54 @@ constexpr bool is_custom_serializable<T, std::void_t<decltype(
     custom_deserialize(std::declval<buffer_span&>(), std::declval<T&>())
 )>> = true;
 
+// He can define 'custom_static_serialized_size(type_tag<T>) -> int' (constexpr) if the
+// serialized size of T is known at compile time.
+
+template <class T, class SFINAE = void>
+constexpr bool has_custom_try_deserialize = false;
+
+template <class T>
+constexpr bool has_custom_try_deserialize<T, std::void_t<decltype(
+    custom_try_deserialize(std::declval<buffer_span&>(), std::declval<T&>())
+)>> = true;
+
+template <class T, class SFINAE = void>
+constexpr bool has_custom_try_serialize = false;
+
+template <class T>
+constexpr bool has_custom_try_serialize<T, std::void_t<decltype(
+    custom_try_serialize(std::declval<buffer_span&>(), std::declval<T const&>())
+)>> = true;
+
+template <class T, class SFINAE = void>
+constexpr bool has_custom_static_serialized_size = false;
+
+template <class T>
+constexpr bool has_custom_static_serialized_size<T, std::void_t<decltype(
+    custom_static_serialized_size(std::declval<type_tag<T>>())
+)>> = true;
+
+// A trivial class which is not an aggregate (eg. it has constructors), or which has an array
+// member or a base class, can't be serialized member by member. If it holds a single value,
+// it can name the type of this value 'serial_representation' : it's then serialized as this
+// value, which is byte-swapped on big-endian hosts. Other such classes must be custom
+// serializable on big-endian hosts.
+
+template <class T>
+using serial_representation_expression = typename T::serial_representation;
+
+template <class T>
+constexpr bool has_serial_representation = is_detected<serial_representation_expression, T>;
+
 // The serial tag of a class is one of the following :
 //
 //   - serial_tag::custom :    nabu::is_custom_serializable<T> is true
-//   - serial_tag::trivial :   std::is_trivially_copyable_v<T> is true
+//   - serial_tag::trivial :   std::is_trivially_copyable_v<T> is true, and the members of T are trivial.
 //   - serial_tag::array :     nabu::is_continuous_iterable<T> is true, and T holds trivial types.
 //   - serial_tag::iterable :  nabu::is_iterable<T> is true, and T holds serializable types.
 //   - serial_tag::aggregate : att::is_aggregate<T> is true, annd T is composed of serializable types.
-//   - serial_tag::invalid :   none of the above.
+//   - serial_tag::invalid :   none of the above, or T is a pointer or long double (it's size and
+//                             format depend on the platform).
 //
 // If a type has the properties of 2+ tags, the first listed is chosen.
 
@@ -184,6 +344,68 @@ using serial_tag_of = decltype(detail::serial_tag<remove_deep_const<std::remove_
 
 namespace detail {
 
+    // att counts the members of an aggregate by brace-initializing it with wildcards : it counts
+    // each element of an array member (brace elision) and the base classes too, and then fails
+    // to bind the members. Such aggregates are not decomposed, they are handled as a whole.
+    // With one braced initializer per member, there is no brace elision, so an array member
+    // makes the initialization fail with too many initializers.
+    template <class T>
+    struct any_base_of {
+        template <class U, class = std::enable_if_t<std::is_base_of_v<U, T> && !std::is_same_v<U, T>>>
+        operator U() const noexcept;
+    };
+
+    template <size_t I>
+    struct any_scalar {
+        template <class U, class = std::enable_if_t<!std::is_class_v<U>>>
+        operator U() const noexcept;
+    };
+
+    template <class T, class SFINAE = void>
+    constexpr bool has_base = false;
+
+    template <class T>
+    constexpr bool has_base<T, std::void_t<decltype(T{ any_base_of<T>{} })>> = true;
+
+    template <class T, class Indices, class SFINAE = void>
+    constexpr bool is_member_wise_constructible = false;
+
+    template <class T, size_t...Is>
+    constexpr bool is_member_wise_constructible<T, std::index_sequence<Is...>, std::void_t<decltype(
+        T{ { any_scalar<Is>{} }... }
+    )>> = true;
+
+    template <class T>
+    constexpr bool is_decomposable_impl() {
+        if constexpr (std::is_class_v<T> && att::is_aggregate<T>)
+             return !has_base<T> && is_member_wise_constructible<T, std::make_index_sequence<att::arity_of<T>>>;
+        else return false;
+    }
+
+    // Indicates that att::as_tuple can split T into it's members.
+    template <class T>
+    constexpr bool is_decomposable = is_decomposable_impl<T>();
+
+    // Views are trivially copyable, but they are serialized as the data they reference :
+    // an aggregate holding one is serialized member by member, like any aggregate.
+    template <class...Ts>
+    constexpr bool has_trivial_members(type_tag<Ts...>) {
+        return (true && ... && std::is_same_v<::nabu::serial_tag_of<Ts>, serial_tag::trivial>);
+    }
+
+    template <class T>
+    constexpr bool has_trivial_members() {
+        if constexpr (std::is_array_v<T>)
+            return has_trivial_members(type_tag<std::remove_all_extents_t<T>>{});
+        else if constexpr (std::is_class_v<T> && is_continuous_iterable<T>)
+            return has_trivial_members(type_tag<mutable_continuous_iterable_type<T>>{});
+        else if constexpr (std::is_class_v<T> && has_serial_representation<T>)
+            return has_trivial_members(type_tag<typename T::serial_representation>{});
+        else if constexpr (is_decomposable<T>)
+            return has_trivial_members(::nabu::tuple_tag<att::to_tuple_t<T>>{});
+        else return true;
+    }
+
     template <class T>
     constexpr auto serial_tag_after_iterable()
     {
@@ -213,7 +435,7 @@ namespace detail {
     template <class T>
     constexpr auto serial_tag()
     {
-        if constexpr (std::is_pointer_v<T>)
+        if constexpr (std::is_pointer_v<T> || std::is_same_v<T, long double>)
         {
             return serial_tag::invalid{};
         }
@@ -223,7 +445,10 @@ namespace detail {
         }
         else if constexpr (std::is_trivially_copyable_v<T>)
         {
-            return serial_tag::trivial{};
+            if constexpr (has_trivial_members<T>()) {
+                   return serial_tag::trivial{};
+            }
+            else { return serial_tag_after_array<T>(); }
         }
         else if constexpr (is_continuous_iterable<T> &&
                           (has_emplace<T> || has_resize<T>))
@@ -253,21 +478,64 @@ namespace detail {
 template <class T>
 constexpr bool is_serializable = detail::is_serializable<T>::value;
 
+// static_serialized_size<T> is the serialized size of any T when it does not depend on
+// it's value (eg. trivial types, and tuples or aggregates composed of such types).
+// Otherwise, it's equal to 'dynamic_serialized_size'.
+
+constexpr int dynamic_serialized_size = -1;
+
+namespace detail {
+    template <class T, class Tag>
+    constexpr int static_serialized_size(Tag) noexcept {
+        return dynamic_serialized_size;
+    }
+    template <class T>
+    constexpr int trivial_serialized_size() noexcept;
+
+    template <class T>
+    constexpr int static_serialized_size(serial_tag::trivial) noexcept {
+        return trivial_serialized_size<T>();
+    }
+    template <class T>
+    constexpr int static_serialized_size(serial_tag::custom) noexcept {
+        if constexpr (has_custom_static_serialized_size<T>)
+             return custom_static_serialized_size(type_tag<T>{});
+        else return dynamic_serialized_size;
+    }
+    template <class T>
+    constexpr int static_serialized_size(serial_tag::aggregate) noexcept;
+}
+
+template <class T>
+constexpr int static_serialized_size = detail::static_serialized_size<
+    remove_deep_const<std::remove_reference_t<T>>
+>(serial_tag_of<T>{});
+
+template <class T>
+constexpr bool has_static_serialized_size = static_serialized_size<T> != dynamic_serialized_size;
+
 // Returns the serialized size in bytes of the given object.
+// It does not throw, unless a custom_serialized_size of T does (eg. to compress the object).
 
 template <class T>
-constexpr int serialized_size(T const& val) noexcept {
-    return detail::serialized_size(val, serial_tag_of<T>{});
+constexpr int serialized_size(T const& val) noexcept(
+    has_static_serialized_size<T> || noexcept(detail::serialized_size(val, serial_tag_of<T>{})))
+{
+    if constexpr (has_static_serialized_size<T>)
+         return static_serialized_size<T>;
+    else return detail::serialized_size(val, serial_tag_of<T>{});
 }
 
 // Returns the serialized size of the 'T' stored in span.
 // If the span cannot contain the object, it returns 'invalid_serialized_size'.
 
-constexpr int invalid_serialized_size = -1;
-
 template <class T>
 int serialized_size(buffer_span const& span, type_tag<T> tag) noexcept {
-    return detail::serialized_size(span, tag, serial_tag_of<T>{});
+    if constexpr (has_static_serialized_size<T>) {
+        constexpr int size = static_serialized_size<T>;
+        return span.size() >= size ? size : invalid_serialized_size;
+    }
+    else return detail::serialized_size(span, tag, serial_tag_of<T>{});
 }
 
 // Serialize 'val' into 'span', advancing 'span.begin'.
@@ -275,6 +543,8 @@ int serialized_size(buffer_span const& span, type_tag<T> tag) noexcept {
 //   - 'serialize' yields undefined behavior (due to buffer overflow).
 //   - 'try_serialize' returns false.
 //   - 'throw_serialize' throws a write_buffer_overflow (std::logic_error).
+// 'try_serialize' checks the span while serializing, in a single pass. On failure,
+// 'span.begin' is restored but the span content can be overwritten.
 
 template <class T>
 void serialize(buffer_span& span, T const& val) {
@@ -282,10 +552,15 @@ void serialize(buffer_span& span, T const& val) {
 }
 template <class T>
 bool try_serialize(buffer_span& span, T const& val) {
-    int const size = serialized_size(val);
-    if (span.size() < size) return false;
-    serialize(span, val);
-    return true;
+    if constexpr (has_static_serialized_size<T>) {
+        if (span.size() < static_serialized_size<T>) return false;
+        serialize(span, val);
+        return true;
+    }
+    auto const begin = span.begin;
+    if (detail::try_serialize(span, val, serial_tag_of<T>{})) return true;
+    span.begin = begin;
+    return false;
 }
 template <class T>
 void throw_serialize(buffer_span& span, T const& val) {
@@ -299,6 +574,8 @@ void throw_serialize(buffer_span& span, T const& val) {
 //   - 'deserialize' yields undefined behavior (due to buffer overflow).
 //   - 'try_deserialize' returns false.
 //   - 'throw_deserialize' throws a read_buffer_overflow (std::runtime_error).
+// 'try_deserialize' checks the span while deserializing, in a single pass. On failure,
+// 'span.begin' is restored but 'val' can be partially overwritten.
 
 template <class T>
 void deserialize(buffer_span& span, T& val) {
@@ -306,10 +583,15 @@ void deserialize(buffer_span& span, T& val) {
 }
 template <class T>
 bool try_deserialize(buffer_span& span, T& val) {
-    int const size = serialized_size(span, type_tag<T>{});
-    if (size == invalid_serialized_size) return false;
-    deserialize(span, val);
-    return true;
+    if constexpr (has_static_serialized_size<T>) {
+        if (span.size() < static_serialized_size<T>) return false;
+        deserialize(span, val);
+        return true;
+    }
+    auto const begin = span.begin;
+    if (detail::try_deserialize(span, val, serial_tag_of<T>{})) return true;
+    span.begin = begin;
+    return false;
 }
 template <class T>
 void throw_deserialize(buffer_span& span, T& val) {
@@ -337,13 +619,21 @@ namespace detail {
     void deserialize(buffer_span& span, T& val, serial_tag::invalid) {
         static_assert(always_false<T>, "[T] is not serializable");
     }
+    template <class T>
+    bool try_serialize(buffer_span& span, T const& val, serial_tag::invalid) {
+        static_assert(always_false<T>, "[T] is not serializable");
+    }
+    template <class T>
+    bool try_deserialize(buffer_span& span, T& val, serial_tag::invalid) {
+        static_assert(always_false<T>, "[T] is not serializable");
+    }
 }
 
 // Indirection for custom types.
 
 namespace detail {
     template <class T>
-    constexpr int serialized_size(T const& val, serial_tag::custom) noexcept {
+    constexpr int serialized_size(T const& val, serial_tag::custom) noexcept(noexcept(custom_serialized_size(val))) {
         return custom_serialized_size(val);
     }
     template <class T>
@@ -358,101 +648,318 @@ namespace detail {
     void deserialize(buffer_span& span, T& val, serial_tag::custom) {
         custom_deserialize(span, val);
     }
+    template <class T>
+    bool try_serialize(buffer_span& span, T const& val, serial_tag::custom) {
+        if constexpr (has_custom_try_serialize<T>) {
+            return custom_try_serialize(span, val);
+        }
+        else {
+            if (span.size() < custom_serialized_size(val)) return false;
+            custom_serialize(span, val);
+            return true;
+        }
+    }
+    template <class T>
+    bool try_deserialize(buffer_span& span, T& val, serial_tag::custom) {
+        if constexpr (has_custom_try_deserialize<T>) {
+            return custom_try_deserialize(span, val);
+        }
+        else {
+            if (custom_serialized_size(span, type_tag<T>{}) == invalid_serialized_size)
+                return false;
+            custom_deserialize(span, val);
+            return true;
+        }
+    }
 }
 
 // Implementation for trivial types.
+// Trivial aggregates having padding bytes use a packed layout : their members are serialized
+// one after the other, so padding is neither sent nor read. Others, and aggregates having an
+// array member or a base class, are copied with memcpy.
+// On big-endian hosts, arithmetic types and enums are byte-swapped to the little-endian wire
+// format, and the trivial types holding them are serialized member by member, or as their
+// serial_representation.
+// Define NABU_REPORT_PADDING (CMake option REPORT_PADDING) to get a deprecation warning
+// for each type serialized with the packed layout.
+
+namespace detail {
+    // The packed size is the sum of the serialized sizes of the members or elements, which
+    // are trivial too.
+    template <class...Ts>
+    constexpr int packed_size_of(type_tag<Ts...>) {
+        return (0 + ... + ::nabu::static_serialized_size<Ts>);
+    }
+
+    template <class T>
+    constexpr int packed_size_of() {
+        if constexpr (std::is_array_v<T>)
+            return std::extent_v<T> * ::nabu::static_serialized_size<std::remove_extent_t<T>>;
+        else if constexpr (std::is_class_v<T> && is_continuous_iterable<T>) {
+            using element_t = mutable_continuous_iterable_type<T>;
+            return sizeof(T) / sizeof(element_t) * ::nabu::static_serialized_size<element_t>;
+        }
+        else if constexpr (std::is_class_v<T> && has_serial_representation<T>)
+             return ::nabu::static_serialized_size<typename T::serial_representation>;
+        else if constexpr (is_decomposable<T>)
+             return packed_size_of(::nabu::tuple_tag<att::to_tuple_t<T>>{});
+        else return sizeof(T);
+    }
+}
+
+// padding_of<T> is the number of padding bytes in the trivial type T, including the
+// padding of its members and elements.
+
+template <class T>
+constexpr int padding_of = sizeof(T) - detail::packed_size_of<T>();
+
+template <class T>
+constexpr bool has_padding = padding_of<T> != 0;
+
+// has_wire_layout<T> indicates that the trivial type T has the same bytes in memory and on
+// the wire, so it's copied with memcpy. It's always true on little-endian hosts, without padding.
 
 namespace detail {
+    template <class T>
+    constexpr bool has_host_byte_order();
+
+    template <class...Ts>
+    constexpr bool has_host_byte_order(type_tag<Ts...>) {
+        return (true && ... && has_host_byte_order<Ts>());
+    }
+
+    template <class T>
+    constexpr bool has_host_byte_order() {
+        if constexpr (is_little_endian_host)
+            return true;
+        else if constexpr (std::is_array_v<T>)
+            return has_host_byte_order<std::remove_all_extents_t<T>>();
+        else if constexpr (std::is_class_v<T> && is_continuous_iterable<T>)
+            return has_host_byte_order<mutable_continuous_iterable_type<T>>();
+        else if constexpr (std::is_class_v<T> && has_serial_representation<T>)
+            return has_host_byte_order<typename T::serial_representation>();
+        else if constexpr (is_decomposable<T>)
+            return has_host_byte_order(::nabu::tuple_tag<att::to_tuple_t<T>>{});
+        else if constexpr (std::is_class_v<T>) {
+            static_assert(always_false<T>, "[T] can't be serialized member by member : on big-endian "
+                "hosts, it must define a serial_representation or be custom serializable");
+            return false;
+        }
+        else return !is_byte_swapped<T>;
+    }
+}
+
+template <class T>
+constexpr bool has_wire_layout = !has_padding<T> && detail::has_host_byte_order<T>();
+
+namespace detail {
+    template <class T>
+    [[deprecated("[T] is serialized with the packed layout because it has padding bytes")]]
+    constexpr void report_padding() noexcept {}
+
+    template <class T>
+    constexpr int trivial_serialized_size() noexcept {
+        if constexpr (has_padding<T>) {
+#if defined(NABU_REPORT_PADDING)
+            report_padding<T>();
+#endif
+            return packed_size_of<T>();
+        }
+        else return sizeof(T);
+    }
+
     template <class T>
     constexpr int serialized_size(T const& val, serial_tag::trivial) noexcept {
-        return sizeof(T);
+        return trivial_serialized_size<T>();
     }
     template <class T>
     int serialized_size(buffer_span const& span, type_tag<T>, serial_tag::trivial) noexcept {
-        return span.size() >= sizeof(T) ? sizeof(T) : invalid_serialized_size;
+        constexpr int size = trivial_serialized_size<T>();
+        return span.size() >= size ? size : invalid_serialized_size;
     }
     template <class T>
     void serialize(buffer_span& span, T const& val, serial_tag::trivial) {
-        memcpy(span.begin, &val, sizeof(T));
-        span.begin += sizeof(T);
+        if constexpr (has_wire_layout<T>) {
+            memcpy(span.begin, &val, sizeof(T));
+            span.begin += sizeof(T);
+        }
+        else if constexpr (is_byte_swapped<T>) {
+            auto const wire = to_little_endian(val);
+            memcpy(span.begin, &wire, sizeof(T));
+            span.begin += sizeof(T);
+        }
+        else if constexpr (is_continuous_iterable<T>) {
+            for (auto const& v : val) ::nabu::serialize(span, v);
+        }
+        else if constexpr (has_serial_representation<T>) {
+            using representation_t = typename T::serial_representation;
+            static_assert(sizeof(representation_t) == sizeof(T), "[T] must hold only it's serial_representation");
+            representation_t representation;
+            memcpy(&representation, &val, sizeof(T));
+            ::nabu::serialize(span, representation);
+        }
+        else {
+            std::apply([&span] (auto const&...vals) {
+                (..., ::nabu::serialize(span, vals));
+            }, att::as_tuple(val));
+        }
     }
     template <class T>
     void deserialize(buffer_span& span, T& val, serial_tag::trivial) {
-        memcpy(&val, span.begin, sizeof(T));
-        span.begin += sizeof(T);
+        if constexpr (has_wire_layout<T>) {
+            memcpy(&val, span.begin, sizeof(T));
+            span.begin += sizeof(T);
+        }
+        else if constexpr (is_byte_swapped<T>) {
+            memcpy(&val, span.begin, sizeof(T));
+            val = from_little_endian(val);
+            span.begin += sizeof(T);
+        }
+        else if constexpr (is_continuous_iterable<T>) {
+            for (auto& v : val) ::nabu::deserialize(span, v);
+        }
+        else if constexpr (has_serial_representation<T>) {
+            typename T::serial_representation representation;
+            ::nabu::deserialize(span, representation);
+            memcpy(&val, &representation, sizeof(T));
+        }
+        else {
+            auto tuple = att::as_tuple(val);
+            std::apply([&span] (auto&...vals) {
+                (..., ::nabu::deserialize(span, vals));
+            }, tuple);
+        }
+    }
+    template <class T>
+    bool try_serialize(buffer_span& span, T const& val, serial_tag::trivial) {
+        if (span.size() < trivial_serialized_size<T>()) return false;
+        serialize(span, val, serial_tag::trivial{});
+        return true;
+    }
+    template <class T>
+    bool try_deserialize(buffer_span& span, T& val, serial_tag::trivial) {
+        if (span.size() < trivial_serialized_size<T>()) return false;
+        deserialize(span, val, serial_tag::trivial{});
+        return true;
     }
 }
 
 // Implementation for array types.
+// Arrays of padded types are serialized element by element, with the packed layout.
+// On big-endian hosts, arrays of arithmetic types and enums are copied then byte-swapped in place.
 
 namespace detail {
     template <class T>
     constexpr int serialized_size(T const& val, serial_tag::array) noexcept {
-        return sizeof(serialized_count_t) + sizeof(continuous_iterable_type<T>) * val.size();
+        return serialized_count_size(val.size(), count_encoding_of<T>{}) +
+            static_serialized_size<continuous_iterable_type<T>> * val.size();
     }
     template <class T>
     int serialized_size(buffer_span const& span, type_tag<T>, serial_tag::array) noexcept {
-        if (span.size() < sizeof(serialized_count_t))
+        size_t count;
+        int const count_size = serialized_count_size(span, count, count_encoding_of<T>{});
+        if (count_size == invalid_serialized_size)
             return invalid_serialized_size;
-        
-        auto s = span;
-        serialized_count_t count;
-        ::nabu::deserialize(s, count);
-        int const size = sizeof(count) + count * sizeof(continuous_iterable_type<T>);
-        return span.size() >= size ? size : invalid_serialized_size;
+
+        auto const size = count_size + count * static_serialized_size<continuous_iterable_type<T>>;
+        return static_cast<size_t>(span.size()) >= size ? static_cast<int>(size) : invalid_serialized_size;
     }
     template <class T>
     void serialize(buffer_span& span, T const& val, serial_tag::array) {
-        NABU_ASSERT_SERIALIZED_COUNT(val.size());
-        auto const count = static_cast<serialized_count_t>(val.size());
-        ::nabu::serialize(span, count);
-
-        auto const size = count * sizeof(continuous_iterable_type<T>);
-        memcpy(span.begin, val.data(), size);
-        span.begin += size;
+        auto const count = val.size();
+        serialize_count(span, count, count_encoding_of<T>{});
+
+        using element_t = mutable_continuous_iterable_type<T>;
+        if constexpr (has_wire_layout<element_t> || is_byte_swapped<element_t>) {
+            auto const size = count * sizeof(element_t);
+            memcpy(span.begin, val.data(), size);
+            if constexpr (is_byte_swapped<element_t>) byte_swap_array<sizeof(element_t)>(span.begin, count);
+            span.begin += size;
+        }
+        else for (auto const& v : val) ::nabu::serialize(span, v);
     }
     template <class T>
     void deserialize(buffer_span& span, T& val, serial_tag::array) {
-        serialized_count_t count;
-        ::nabu::deserialize(span, count);
-
-        T array;
-        if constexpr (has_resize<T>) {
-            array.resize(count);
-            auto const size = count * sizeof(continuous_iterable_type<T>);
-            memcpy(array.data(), span.begin, size);
+        auto const count = deserialize_count(span, count_encoding_of<T>{});
+
+        // The storage of 'val' is reused.
+        using element_t = mutable_continuous_iterable_type<T>;
+        if constexpr (has_resize<T> && (has_wire_layout<element_t> || is_byte_swapped<element_t>)) {
+            val.resize(count);
+            auto const size = count * sizeof(element_t);
+            memcpy(std::data(val), span.begin, size);
+            if constexpr (is_byte_swapped<element_t>)
+                byte_swap_array<sizeof(element_t)>(reinterpret_cast<std::byte*>(std::data(val)), count);
             span.begin += size;
         }
+        else if constexpr (has_resize<T>) {
+            val.resize(count);
+            for (auto& v : val) ::nabu::deserialize(span, v);
+        }
         else {
-            reserve(array, count);
+            clear(val);
+            reserve(val, count);
             mutable_continuous_iterable_type<T> v;
-            for (int i = 0; i < count; ++i) {
+            for (size_t i = 0; i < count; ++i) {
                 ::nabu::deserialize(span, v);
-                emplace(array, v);
+                emplace(val, v);
             }
         }
-        val = std::move(array);
+    }
+    template <class T>
+    bool try_serialize(buffer_span& span, T const& val, serial_tag::array) {
+        if (span.size() < serialized_size(val, serial_tag::array{})) return false;
+        serialize(span, val, serial_tag::array{});
+        return true;
+    }
+    template <class T>
+    bool try_deserialize(buffer_span& span, T& val, serial_tag::array) {
+        if (serialized_size(span, type_tag<T>{}, serial_tag::array{}) == invalid_serialized_size)
+            return false;
+        deserialize(span, val, serial_tag::array{});
+        return true;
     }
 }
 
 // Implementation for iterable types.
 
 namespace detail {
+    // Sequences are resized, then their elements are deserialized in place. It requires
+    // references to the elements : std::vector<bool> gives proxies, so it's emplaced into.
+    template <class T>
+    constexpr bool is_deserialized_in_place_impl() {
+        if constexpr (has_resize<T>)
+             return std::is_lvalue_reference_v<decltype(*std::begin(std::declval<T&>()))>;
+        else return false;
+    }
+
+    template <class T>
+    constexpr bool is_deserialized_in_place = is_deserialized_in_place_impl<T>();
+
     template <class T>
     constexpr int serialized_size(T const& val, serial_tag::iterable) noexcept {
-        int sum = sizeof(serialized_count_t);
+        auto const count = std::size(val);
+        int sum = serialized_count_size(count, count_encoding_of<T>{});
+        if constexpr (has_static_serialized_size<iterable_type<T>>) {
+            return sum + static_cast<int>(count) * static_serialized_size<iterable_type<T>>;
+        }
         for (auto const& v : val) sum += ::nabu::serialized_size(v);
         return sum;
     }
     template <class T>
     int serialized_size(buffer_span const& span, type_tag<T>, serial_tag::iterable) noexcept {
-        if (span.size() < sizeof(serialized_count_t))
+        size_t count;
+        int const count_size = serialized_count_size(span, count, count_encoding_of<T>{});
+        if (count_size == invalid_serialized_size)
             return invalid_serialized_size;
-        
+
+        if constexpr (has_static_serialized_size<iterable_type<T>>) {
+            auto const size = count_size + count * static_serialized_size<iterable_type<T>>;
+            return static_cast<size_t>(span.size()) >= size ? static_cast<int>(size) : invalid_serialized_size;
+        }
         auto s = span;
-        serialized_count_t count;
-        ::nabu::deserialize(s, count);
-        for (int i = 0; i < count; ++i) {
+        s.begin += count_size;
+        for (size_t i = 0; i < count; ++i) {
             int const size = ::nabu::serialized_size(s, type_tag<iterable_type<T>>{});
             if (size == invalid_serialized_size) return invalid_serialized_size;
             s.begin += size;
@@ -461,24 +968,79 @@ namespace detail {
     }
     template <class T>
     void serialize(buffer_span& span, T const& val, serial_tag::iterable) {
-        NABU_ASSERT_SERIALIZED_COUNT(val.size());
-        auto const count = static_cast<serialized_count_t>(val.size());
-        ::nabu::serialize(span, count);
+        serialize_count(span, std::size(val), count_encoding_of<T>{});
         for (auto const& v : val) ::nabu::serialize(span, v);
     }
     template <class T>
     void deserialize(buffer_span& span, T& val, serial_tag::iterable) {
-        serialized_count_t count;
-        ::nabu::deserialize(span, count);
+        auto const count = deserialize_count(span, count_encoding_of<T>{});
 
-        T iterable;
-        reserve(iterable, count);
+        // The storage of 'val' is reused. For sequences, the elements are deserialized
+        // in place so they reuse their storage too.
+        if constexpr (is_deserialized_in_place<T>) {
+            val.resize(count);
+            for (auto& v : val) ::nabu::deserialize(span, v);
+        }
+        // Ordered containers were serialized in order, so each element is emplaced at the end.
+        // Hash containers are reserved once.
+        else {
+            clear(val);
+            reserve(val, count);
+            mutable_iterable_type<T> v;
+            for (size_t i = 0; i < count; ++i) {
+                ::nabu::deserialize(span, v);
+                emplace_sorted(val, std::move(v));
+            }
+        }
+    }
+    template <class T>
+    bool try_serialize(buffer_span& span, T const& val, serial_tag::iterable) {
+        auto const count = std::size(val);
+        if (span.size() < serialized_count_size(count, count_encoding_of<T>{})) return false;
+        serialize_count(span, count, count_encoding_of<T>{});
+
+        if constexpr (has_static_serialized_size<iterable_type<T>>) {
+            if (static_cast<size_t>(span.size()) < count * static_serialized_size<iterable_type<T>>)
+                return false;
+            for (auto const& v : val) ::nabu::serialize(span, v);
+        }
+        else for (auto const& v : val) {
+            if (!::nabu::try_serialize(span, v)) return false;
+        }
+        return true;
+    }
+    template <class T>
+    bool try_deserialize(buffer_span& span, T& val, serial_tag::iterable) {
+        size_t count;
+        int const count_size = serialized_count_size(span, count, count_encoding_of<T>{});
+        if (count_size == invalid_serialized_size)
+            return false;
+        span.begin += count_size;
+
+        if constexpr (has_static_serialized_size<iterable_type<T>>) {
+            if (static_cast<size_t>(span.size()) < count * static_serialized_size<iterable_type<T>>)
+                return false;
+        }
+
+        // A corrupted count must not trigger a huge allocation : elements are
+        // emplaced one by one if they could be smaller than one byte.
+        if constexpr (is_deserialized_in_place<T>) {
+            if (count <= static_cast<size_t>(span.size())) {
+                val.resize(count);
+                for (auto& v : val) {
+                    if (!::nabu::try_deserialize(span, v)) return false;
+                }
+                return true;
+            }
+        }
+        clear(val);
+        reserve(val, std::min(count, static_cast<size_t>(span.size())));
         mutable_iterable_type<T> v;
-        for (int i = 0; i < count; ++i) {
-            ::nabu::deserialize(span, v);
-            emplace(iterable, std::move(v));
+        for (size_t i = 0; i < count; ++i) {
+            if (!::nabu::try_deserialize(span, v)) return false;
+            emplace_sorted(val, std::move(v));
         }
-        val = std::move(iterable);
+        return true;
     }
 }
 
@@ -486,23 +1048,31 @@ namespace detail {
 
 template <class...Ts>
 constexpr int custom_serialized_size(std::tuple<Ts...> const& tuple) noexcept {
-    return (0 + ... + serialized_size(std::get<Ts>(tuple)));
-}
-
-constexpr int custom_serialized_size(buffer_span const& span, type_tag<std::tuple<>>) noexcept {
-    return 0;
+    return std::apply([] (auto const&...vals) {
+        return (0 + ... + serialized_size(vals));
+    }, tuple);
 }
-template <class T, class...Ts>
-constexpr int custom_serialized_size(buffer_span const& span, type_tag<std::tuple<T, Ts...>>) noexcept {
-    int const size = serialized_size(span, type_tag<T>{});
-    if (size == invalid_serialized_size) return invalid_serialized_size;
 
+template <class...Ts>
+int custom_serialized_size(buffer_span const& span, type_tag<std::tuple<Ts...>>) noexcept {
     auto s = span;
-    s.begin += size;
-    int const rec = serialized_size(s, type_tag<std::tuple<Ts...>>{});
-    if (rec == invalid_serialized_size) return invalid_serialized_size;
+    auto const advance = [&s] (auto tag) {
+        int const size = serialized_size(s, tag);
+        if (size == invalid_serialized_size) return false;
+        s.begin += size;
+        return true;
+    };
+    if (!(... && advance(type_tag<remove_deep_const<std::remove_reference_t<Ts>>>{})))
+        return invalid_serialized_size;
+    return s.begin - span.begin;
+}
 
-    return size + rec;
+template <class...Ts>
+constexpr int custom_static_serialized_size(type_tag<std::tuple<Ts...>>) noexcept {
+    constexpr bool is_static = (true && ... && has_static_serialized_size<Ts>);
+    if constexpr (is_static)
+         return (0 + ... + static_serialized_size<Ts>);
+    else return dynamic_serialized_size;
 }
 
 template <class...Ts>
@@ -519,9 +1089,27 @@ void custom_deserialize(buffer_span& span, std::tuple<Ts...>& tuple) {
     });
 }
 
+template <class...Ts>
+bool custom_try_serialize(buffer_span& span, std::tuple<Ts...> const& tuple) {
+    return std::apply([&span] (auto const&...vals) {
+        return (... && try_serialize(span, vals));
+    }, tuple);
+}
+
+template <class...Ts>
+bool custom_try_deserialize(buffer_span& span, std::tuple<Ts...>& tuple) {
+    return std::apply([&span] (auto&...vals) {
+        return (... && try_deserialize(span, vals));
+    }, tuple);
+}
+
 // Implementation for aggregates (same as tuples).
 
 namespace detail {
+    template <class T>
+    constexpr int static_serialized_size(serial_tag::aggregate) noexcept {
+        return ::nabu::static_serialized_size<att::to_tuple_t<T>>;
+    }
     template <class T>
     constexpr int serialized_size(T const& val, serial_tag::aggregate) noexcept {
         return ::nabu::serialized_size(att::as_tuple(val));
@@ -539,6 +1127,15 @@ namespace detail {
     void deserialize(buffer_span& span, T& val, serial_tag::aggregate) {
         ::nabu::deserialize(span, att::as_tuple(val));
     }
+    template <class T>
+    bool try_serialize(buffer_span& span, T const& val, serial_tag::aggregate) {
+        return custom_try_serialize(span, att::as_tuple(val));
+    }
+    template <class T>
+    bool try_deserialize(buffer_span& span, T& val, serial_tag::aggregate) {
+        auto tuple = att::as_tuple(val);
+        return custom_try_deserialize(span, tuple);
+    }
 }
 
 } // nabu
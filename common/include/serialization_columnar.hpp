@@ -0,0 +1,137 @@
+#pragma once
+
+#include <serialization_base.hpp>
+#include <utility>
+#include <vector>
+
+
+namespace nabu {
+
+// columnar_vector<T> is a std::vector of aggregates serialized column by column : the count,
+// then the first member of every element, then the second member of every element, etc.
+// Values of a member are contiguous on the wire, so trivial columns are written and read
+// by tight copy loops, and the payload compresses much better than interleaved members.
+// It suits long lists of small aggregates, like entity or tile lists.
+
+template <class T>
+class columnar_vector : public std::vector<T> {
+    static_assert(att::is_aggregate<T>, "[T] must be an aggregate");
+    static_assert(att::arity_of<T> > 0, "[T] must have at least one member");
+public:
+    using std::vector<T>::vector;
+};
+
+// columnar_vector<T> uses the count encoding of std::vector<T>.
+
+template <class T>
+struct serial_traits<columnar_vector<T>> : serial_traits<std::vector<T>> {};
+
+namespace detail {
+    template <class T, size_t I>
+    using column_type = std::tuple_element_t<I, att::to_tuple_t<T>>;
+
+    // Returns the member I of 'val'.
+    template <size_t I, class T>
+    decltype(auto) column(T& val) noexcept {
+        return std::get<I>(att::as_tuple(val));
+    }
+
+    // Calls 'f' with std::integral_constant<size_t, I> for each column I of T, while it returns true.
+    template <class T, class F, size_t...Is>
+    bool for_each_column(F&& f, std::index_sequence<Is...>) {
+        return (... && f(std::integral_constant<size_t, Is>{}));
+    }
+    template <class T, class F>
+    bool for_each_column(F&& f) {
+        return for_each_column<T>(f, std::make_index_sequence<att::arity_of<T>>{});
+    }
+
+    // Reads the count of a columnar_vector<T>, without advancing 'span'.
+    // Every element takes at least one byte, so a count larger than the span is invalid.
+    template <class T>
+    int columnar_count_size(buffer_span const& span, size_t& count) noexcept {
+        int const count_size = serialized_count_size(span, count, count_encoding_of<columnar_vector<T>>{});
+        if (count_size == invalid_serialized_size ||
+            count > static_cast<size_t>(span.size() - count_size))
+            return invalid_serialized_size;
+        return count_size;
+    }
+}
+
+template <class T>
+int custom_serialized_size(columnar_vector<T> const& vec) noexcept {
+    int size = serialized_count_size(vec.size(), count_encoding_of<columnar_vector<T>>{});
+    detail::for_each_column<T>([&] (auto i) {
+        using U = detail::column_type<T, decltype(i)::value>;
+        if constexpr (has_static_serialized_size<U>) {
+            size += static_serialized_size<U> * static_cast<int>(vec.size());
+        }
+        else for (auto const& v : vec) {
+            size += serialized_size(detail::column<decltype(i)::value>(v));
+        }
+        return true;
+    });
+    return size;
+}
+
+template <class T>
+int custom_serialized_size(buffer_span const& span, type_tag<columnar_vector<T>>) noexcept {
+    size_t count;
+    int const count_size = detail::columnar_count_size<T>(span, count);
+    if (count_size == invalid_serialized_size) return invalid_serialized_size;
+
+    auto s = buffer_span{ span.begin + count_size, span.end };
+    bool const valid = detail::for_each_column<T>([&] (auto i) {
+        using U = detail::column_type<T, decltype(i)::value>;
+        if constexpr (has_static_serialized_size<U>) {
+            auto const size = count * static_serialized_size<U>;
+            if (static_cast<size_t>(s.size()) < size) return false;
+            s.begin += size;
+        }
+        else for (size_t j = 0; j < count; ++j) {
+            int const size = serialized_size(s, type_tag<U>{});
+            if (size == invalid_serialized_size) return false;
+            s.begin += size;
+        }
+        return true;
+    });
+    return valid ? static_cast<int>(s.begin - span.begin) : invalid_serialized_size;
+}
+
+template <class T>
+void custom_serialize(buffer_span& span, columnar_vector<T> const& vec) {
+    serialize_count(span, vec.size(), count_encoding_of<columnar_vector<T>>{});
+    detail::for_each_column<T>([&] (auto i) {
+        for (auto const& v : vec) serialize(span, detail::column<decltype(i)::value>(v));
+        return true;
+    });
+}
+
+// The storage of 'vec' is reused.
+
+template <class T>
+void custom_deserialize(buffer_span& span, columnar_vector<T>& vec) {
+    vec.resize(deserialize_count(span, count_encoding_of<columnar_vector<T>>{}));
+    detail::for_each_column<T>([&] (auto i) {
+        for (auto& v : vec) deserialize(span, detail::column<decltype(i)::value>(v));
+        return true;
+    });
+}
+
+template <class T>
+bool custom_try_deserialize(buffer_span& span, columnar_vector<T>& vec) {
+    size_t count;
+    int const count_size = detail::columnar_count_size<T>(span, count);
+    if (count_size == invalid_serialized_size) return false;
+
+    span.begin += count_size;
+    vec.resize(count);
+    return detail::for_each_column<T>([&] (auto i) {
+        for (auto& v : vec) {
+            if (!try_deserialize(span, detail::column<decltype(i)::value>(v))) return false;
+        }
+        return true;
+    });
+}
+
+} // nabu
@@ -0,0 +1,305 @@
+#pragma once
+
+#include <serialization.hpp>
+#include <utility>
+
+
+namespace nabu {
+
+// Delta serialization writes only what changed in 'current' compared to 'baseline'.
+// The receiver must hold the same baseline, which is updated in place by 'deserialize_delta'.
+// It's available for aggregates and iterables, with these formats :
+//
+//   - aggregates : a bit mask of the changed members, then the changed members. Trivial
+//     aggregates (eg. a position of two floats) are delta serialized member by member too.
+//   - sequences (iterables with resize) : if the count did not change, the count, a bit mask
+//     of the changed elements, then the changed elements. Otherwise, the whole sequence.
+//   - other iterables : a bool indicating a change, then the whole iterable if it changed.
+//
+// Changed members and elements are themselves delta serialized if they are aggregates or
+// iterables. Members are compared with 'operator==' if it exists, recursively otherwise.
+
+namespace detail {
+    template <class T>
+    constexpr bool is_trivial_aggregate =
+        std::is_same_v<serial_tag_of<T>, serial_tag::trivial> &&
+        !is_continuous_iterable<T> && is_decomposable<T>;
+
+    // The serial tag used to delta serialize T.
+    template <class T>
+    using delta_tag_of = std::conditional_t<is_trivial_aggregate<remove_deep_const<T>>,
+        serial_tag::aggregate,
+        serial_tag_of<T>
+    >;
+}
+
+template <class T>
+constexpr bool is_delta_serializable =
+    std::is_same_v<detail::delta_tag_of<T>, serial_tag::aggregate> ||
+    std::is_same_v<detail::delta_tag_of<T>, serial_tag::iterable>;
+
+namespace detail {
+    template <class T>
+    using equal_expression = decltype(std::declval<T const&>() == std::declval<T const&>());
+
+    template <class...Ts>
+    bool delta_equal(std::tuple<Ts...> const& lhs, std::tuple<Ts...> const& rhs);
+
+    template <class T>
+    bool delta_equal(T const& lhs, T const& rhs) {
+        if constexpr (std::is_same_v<serial_tag_of<T>, serial_tag::array>) {
+            return lhs == rhs;
+        }
+        else if constexpr (is_iterable<T>) {
+            if (std::size(lhs) != std::size(rhs)) return false;
+            auto it = std::begin(rhs);
+            for (auto const& v : lhs) {
+                if (!delta_equal(v, *it)) return false;
+                ++it;
+            }
+            return true;
+        }
+        else if constexpr (is_detected<equal_expression, T>) {
+            return lhs == rhs;
+        }
+        else if constexpr (att::is_aggregate<T>) {
+            return delta_equal(att::as_tuple(lhs), att::as_tuple(rhs));
+        }
+        else {
+            static_assert(always_false<T>, "[T] cannot be compared for delta serialization");
+        }
+    }
+    template <class...Ts>
+    bool delta_equal(std::tuple<Ts...> const& lhs, std::tuple<Ts...> const& rhs) {
+        return std::apply([&rhs] (auto const&...ls) {
+            return std::apply([&ls...] (auto const&...rs) {
+                return (true && ... && delta_equal(ls, rs));
+            }, rhs);
+        }, lhs);
+    }
+
+    // Bit masks are written before the members or elements they describe.
+
+    template <bool Checked>
+    bool reserve_mask(buffer_span& span, size_t const bits, std::byte*& mask) {
+        auto const size = (bits + 7) / 8;
+        if constexpr (Checked) {
+            if (static_cast<size_t>(span.size()) < size) return false;
+        }
+        mask = span.begin;
+        memset(mask, 0, size);
+        span.begin += size;
+        return true;
+    }
+    template <bool Checked>
+    bool read_mask(buffer_span& span, size_t const bits, std::byte const*& mask) {
+        auto const size = (bits + 7) / 8;
+        if constexpr (Checked) {
+            if (static_cast<size_t>(span.size()) < size) return false;
+        }
+        mask = span.begin;
+        span.begin += size;
+        return true;
+    }
+    inline void set_mask_bit(std::byte* const mask, size_t const i) noexcept {
+        mask[i / 8] |= static_cast<std::byte>(1 << (i % 8));
+    }
+    inline bool mask_bit(std::byte const* const mask, size_t const i) noexcept {
+        return (mask[i / 8] & static_cast<std::byte>(1 << (i % 8))) != std::byte{ 0 };
+    }
+
+    template <bool Checked, class T>
+    bool delta_write(buffer_span& span, T const& val) {
+        if constexpr (Checked) {
+            return ::nabu::try_serialize(span, val);
+        }
+        else {
+            ::nabu::serialize(span, val);
+            return true;
+        }
+    }
+    template <bool Checked, class T>
+    bool delta_read(buffer_span& span, T& val) {
+        if constexpr (Checked) {
+            return ::nabu::try_deserialize(span, val);
+        }
+        else {
+            ::nabu::deserialize(span, val);
+            return true;
+        }
+    }
+
+    template <bool Checked, class T>
+    bool serialize_delta(buffer_span& span, T const& current, T const& baseline, serial_tag::aggregate);
+    template <bool Checked, class T>
+    bool serialize_delta(buffer_span& span, T const& current, T const& baseline, serial_tag::iterable);
+    template <bool Checked, class T>
+    bool deserialize_delta(buffer_span& span, T& val, serial_tag::aggregate);
+    template <bool Checked, class T>
+    bool deserialize_delta(buffer_span& span, T& val, serial_tag::iterable);
+
+    template <bool Checked, class T>
+    bool serialize_changed(buffer_span& span, T const& current, T const& baseline) {
+        if constexpr (is_delta_serializable<T>)
+             return serialize_delta<Checked>(span, current, baseline, delta_tag_of<T>{});
+        else return delta_write<Checked>(span, current);
+    }
+    template <bool Checked, class T>
+    bool deserialize_changed(buffer_span& span, T& val) {
+        if constexpr (is_delta_serializable<T>)
+             return deserialize_delta<Checked>(span, val, delta_tag_of<T>{});
+        else return delta_read<Checked>(span, val);
+    }
+
+    template <bool Checked, class Tuple, size_t...Is>
+    bool serialize_members_delta(buffer_span& span, std::byte* const mask,
+        Tuple const& current, Tuple const& baseline, std::index_sequence<Is...>)
+    {
+        auto const member = [&span, mask] (size_t const i, auto const& cur, auto const& base) {
+            if (delta_equal(cur, base)) return true;
+            set_mask_bit(mask, i);
+            return serialize_changed<Checked>(span, cur, base);
+        };
+        return (true && ... && member(Is, std::get<Is>(current), std::get<Is>(baseline)));
+    }
+    template <bool Checked, class Tuple, size_t...Is>
+    bool deserialize_members_delta(buffer_span& span, std::byte const* const mask,
+        Tuple& tuple, std::index_sequence<Is...>)
+    {
+        return (true && ... && (!mask_bit(mask, Is) || deserialize_changed<Checked>(span, std::get<Is>(tuple))));
+    }
+
+    template <bool Checked, class T>
+    bool serialize_delta(buffer_span& span, T const& current, T const& baseline, serial_tag::aggregate) {
+        auto const cur  = att::as_tuple(current);
+        auto const base = att::as_tuple(baseline);
+        constexpr size_t arity = std::tuple_size_v<std::remove_const_t<decltype(cur)>>;
+
+        std::byte* mask;
+        if (!reserve_mask<Checked>(span, arity, mask)) return false;
+        return serialize_members_delta<Checked>(span, mask, cur, base, std::make_index_sequence<arity>{});
+    }
+    template <bool Checked, class T>
+    bool deserialize_delta(buffer_span& span, T& val, serial_tag::aggregate) {
+        auto tuple = att::as_tuple(val);
+        constexpr size_t arity = std::tuple_size_v<decltype(tuple)>;
+
+        std::byte const* mask;
+        if (!read_mask<Checked>(span, arity, mask)) return false;
+        return deserialize_members_delta<Checked>(span, mask, tuple, std::make_index_sequence<arity>{});
+    }
+
+    template <bool Checked, class T>
+    bool serialize_delta(buffer_span& span, T const& current, T const& baseline, serial_tag::iterable) {
+        if constexpr (has_resize<T>) {
+            auto const count = std::size(current);
+            if (count != std::size(baseline)) return delta_write<Checked>(span, current);
+
+            using encoding = count_encoding_of<T>;
+            if constexpr (Checked) {
+                if (span.size() < serialized_count_size(count, encoding{})) return false;
+            }
+            serialize_count(span, count, encoding{});
+
+            std::byte* mask;
+            if (!reserve_mask<Checked>(span, count, mask)) return false;
+            auto base = std::begin(baseline);
+            size_t i = 0;
+            for (auto const& cur : current) {
+                if (!delta_equal(cur, *base)) {
+                    set_mask_bit(mask, i);
+                    if (!serialize_changed<Checked>(span, cur, *base)) return false;
+                }
+                ++base;
+                ++i;
+            }
+            return true;
+        }
+        else {
+            bool const changed = !delta_equal(current, baseline);
+            if (!delta_write<Checked>(span, changed)) return false;
+            return !changed || delta_write<Checked>(span, current);
+        }
+    }
+    template <bool Checked, class T>
+    bool deserialize_delta(buffer_span& span, T& val, serial_tag::iterable) {
+        if constexpr (has_resize<T>) {
+            using encoding = count_encoding_of<T>;
+            size_t count;
+            int const count_size = serialized_count_size(span, count, encoding{});
+            if constexpr (Checked) {
+                if (count_size == invalid_serialized_size) return false;
+            }
+            if (count != std::size(val)) return delta_read<Checked>(span, val);
+            span.begin += count_size;
+
+            std::byte const* mask;
+            if (!read_mask<Checked>(span, count, mask)) return false;
+            size_t i = 0;
+            for (auto& v : val) {
+                if (mask_bit(mask, i) && !deserialize_changed<Checked>(span, v)) return false;
+                ++i;
+            }
+            return true;
+        }
+        else {
+            bool changed;
+            if (!delta_read<Checked>(span, changed)) return false;
+            return !changed || delta_read<Checked>(span, val);
+        }
+    }
+}
+
+// Serialize the changes from 'baseline' to 'current' into 'span', advancing 'span.begin'.
+// On failure :
+//   - 'serialize_delta' yields undefined behavior (due to buffer overflow).
+//   - 'try_serialize_delta' returns false and restores 'span.begin'.
+//   - 'throw_serialize_delta' throws a write_buffer_overflow (std::logic_error).
+
+template <class T>
+void serialize_delta(buffer_span& span, T const& current, T const& baseline) {
+    static_assert(is_delta_serializable<T>, "[T] must be an aggregate or an iterable");
+    detail::serialize_delta<false>(span, current, baseline, detail::delta_tag_of<T>{});
+}
+template <class T>
+bool try_serialize_delta(buffer_span& span, T const& current, T const& baseline) {
+    static_assert(is_delta_serializable<T>, "[T] must be an aggregate or an iterable");
+    auto const begin = span.begin;
+    if (detail::serialize_delta<true>(span, current, baseline, detail::delta_tag_of<T>{})) return true;
+    span.begin = begin;
+    return false;
+}
+template <class T>
+void throw_serialize_delta(buffer_span& span, T const& current, T const& baseline) {
+    if (!try_serialize_delta(span, current, baseline)) throw write_buffer_overflow{ fmt::format(
+        "Tried to serialize the delta of an object of type '{}' in a too small span of size {}",
+        name_of<T>(), span.size() )};
+}
+
+// Apply the changes stored in 'span' to 'val', which holds the baseline, advancing 'span.begin'.
+// On failure :
+//   - 'deserialize_delta' yields undefined behavior (due to buffer overflow).
+//   - 'try_deserialize_delta' returns false and restores 'span.begin'. 'val' can be partially updated.
+//   - 'throw_deserialize_delta' throws a read_buffer_overflow (std::runtime_error).
+
+template <class T>
+void deserialize_delta(buffer_span& span, T& val) {
+    static_assert(is_delta_serializable<T>, "[T] must be an aggregate or an iterable");
+    detail::deserialize_delta<false>(span, val, detail::delta_tag_of<T>{});
+}
+template <class T>
+bool try_deserialize_delta(buffer_span& span, T& val) {
+    static_assert(is_delta_serializable<T>, "[T] must be an aggregate or an iterable");
+    auto const begin = span.begin;
+    if (detail::deserialize_delta<true>(span, val, detail::delta_tag_of<T>{})) return true;
+    span.begin = begin;
+    return false;
+}
+template <class T>
+void throw_deserialize_delta(buffer_span& span, T& val) {
+    if (!try_deserialize_delta(span, val)) throw read_buffer_overflow{ fmt::format(
+        "Tried to deserialize the delta of an object of type '{}' from an invalid span of size {}",
+        name_of<T>(), span.size() )};
+}
+
+} // nabu
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <serialization_base.hpp>
+#include <algorithm>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+
+namespace nabu {
+
+// interned_string is a std::string sent in full the first time, then as a small handle.
+// Both ends of a connection keep a string_table per direction, selected on the thread
+// serializing or deserializing a message with an interning_scope. Without a scope, the
+// strings are always sent in full.
+//
+// Wire format, a varint followed by :
+//   - handle << 1 | 1 : nothing, the string is the one registered with this handle.
+//   - size << 1 :       'size' chars.
+//
+// Strings sent in full are registered by both ends when the scope is committed, in the
+// order of their first appearance. This is done once the whole message was serialized, so a
+// message failing to serialize is not sent and leaves the tables in sync.
+
+class interned_string : public std::string {
+public:
+    using std::string::string;
+
+    interned_string(std::string str) noexcept :
+        std::string{ std::move(str) } {}
+};
+
+// The strings registered in one direction of a connection.
+
+class string_table {
+    std::deque<std::string> strings_;
+    std::unordered_map<std::string_view, uint32_t> handles_;
+    std::vector<std::string> pending_;
+
+public:
+    // Tables stop registering strings when full, so that they stay bounded.
+    static constexpr size_t max_size = 4096;
+
+    size_t size() const noexcept { return strings_.size(); }
+
+    // Returns true and sets 'handle' if 'str' is registered.
+    bool find(std::string_view const str, uint32_t& handle) const noexcept {
+        auto const it = handles_.find(str);
+        if (it == handles_.end()) return false;
+        handle = it->second;
+        return true;
+    }
+
+    // Returns the string registered with 'handle', or nullptr.
+    std::string const* at(size_t const handle) const noexcept {
+        return handle < strings_.size() ? &strings_[handle] : nullptr;
+    }
+
+    // Adds 'str' to the strings registered by the next commit.
+    void insert(std::string_view const str) {
+        if (strings_.size() + pending_.size() >= max_size) return;
+        if (std::find(pending_.begin(), pending_.end(), str) != pending_.end()) return;
+        pending_.emplace_back(str);
+    }
+
+    // Registers the inserted strings.
+    void commit() {
+        for (auto& str : pending_) {
+            if (handles_.count(str)) continue;
+            auto const& registered = strings_.emplace_back(std::move(str));
+            handles_.emplace(registered, static_cast<uint32_t>(strings_.size() - 1));
+        }
+        pending_.clear();
+    }
+
+    // Forgets the strings inserted since the last commit.
+    void rollback() noexcept {
+        pending_.clear();
+    }
+
+    void clear() noexcept {
+        strings_.clear();
+        handles_.clear();
+        pending_.clear();
+    }
+};
+
+namespace detail {
+    inline string_table*& current_string_table() noexcept {
+        static thread_local string_table* table = nullptr;
+        return table;
+    }
+}
+
+// Selects 'table' for the interned strings (de)serialized on this thread, until destruction.
+// The strings seen are registered by 'commit', and forgotten if it's not called.
+//
+// The receiving table stays in sync only if every message committed by the sender is
+// deserialized and committed, in order. A message the receiver skips (eg. without callback)
+// or fails to deserialize may hold strings sent in full, so the next handles would resolve
+// to the wrong strings : both tables of the connection must be cleared, by reconnecting.
+
+class interning_scope {
+    string_table& table_;
+    string_table* previous_;
+
+public:
+    explicit interning_scope(string_table& table) noexcept :
+        table_{ table },
+        previous_{ std::exchange(detail::current_string_table(), &table) } {}
+
+    ~interning_scope() {
+        table_.rollback();
+        detail::current_string_table() = previous_;
+    }
+
+    interning_scope(interning_scope const&) = delete;
+    interning_scope& operator=(interning_scope const&) = delete;
+
+    void commit() { table_.commit(); }
+};
+
+// Implementation for interned_string.
+
+namespace detail {
+    using interning_encoding = count_encoding::varint;
+
+    inline bool find_interned(std::string_view const str, uint32_t& handle) noexcept {
+        auto const table = current_string_table();
+        return table && table->find(str, handle);
+    }
+}
+
+inline int custom_serialized_size(interned_string const& str) noexcept {
+    using encoding = detail::interning_encoding;
+    uint32_t handle;
+    if (detail::find_interned(str, handle))
+        return serialized_count_size(size_t{ handle } << 1 | 1, encoding{});
+    return serialized_count_size(str.size() << 1, encoding{}) + static_cast<int>(str.size());
+}
+
+inline int custom_serialized_size(buffer_span const& span, type_tag<interned_string>) noexcept {
+    size_t header;
+    int const header_size = serialized_count_size(span, header, detail::interning_encoding{});
+    if (header_size == invalid_serialized_size) return invalid_serialized_size;
+    if (header & 1) return header_size;
+
+    auto const size = header >> 1;
+    if (size > static_cast<size_t>(span.size() - header_size)) return invalid_serialized_size;
+    return header_size + static_cast<int>(size);
+}
+
+inline void custom_serialize(buffer_span& span, interned_string const& str) {
+    using encoding = detail::interning_encoding;
+    uint32_t handle;
+    if (detail::find_interned(str, handle)) {
+        serialize_count(span, size_t{ handle } << 1 | 1, encoding{});
+        return;
+    }
+    serialize_count(span, str.size() << 1, encoding{});
+    memcpy(span.begin, str.data(), str.size());
+    span.begin += str.size();
+    if (auto const table = detail::current_string_table()) table->insert(str);
+}
+
+inline bool custom_try_deserialize(buffer_span& span, interned_string& str) {
+    size_t header;
+    int const header_size = serialized_count_size(span, header, detail::interning_encoding{});
+    if (header_size == invalid_serialized_size) return false;
+
+    auto const table = detail::current_string_table();
+    if (header & 1) {
+        auto const registered = table ? table->at(header >> 1) : nullptr;
+        if (!registered) return false;
+        str.assign(*registered);
+        span.begin += header_size;
+        return true;
+    }
+
+    auto const size = header >> 1;
+    if (size > static_cast<size_t>(span.size() - header_size)) return false;
+    str.assign(reinterpret_cast<char const*>(span.begin + header_size), size);
+    span.begin += header_size + size;
+    if (table) table->insert(str);
+    return true;
+}
+
+inline void custom_deserialize(buffer_span& span, interned_string& str) {
+    [[maybe_unused]] bool const valid = custom_try_deserialize(span, str);
+    NABU_ASSERT(valid, "Tried to deserialize an interned string with an unknown handle");
+}
+
+} // nabu
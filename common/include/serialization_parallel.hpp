@@ -0,0 +1,198 @@
+#pragma once
+
+#include <serialization.hpp>
+#include <thread_pool.hpp>
+#include <algorithm>
+#include <exception>
+#include <iterator>
+#include <utility>
+
+
+namespace nabu {
+
+// Containers with the array or iterable serial tag are serialized by chunks on the thread pool,
+// when they hold at least 'parallel_serialization_threshold' elements : the chunks are sized
+// concurrently, their offsets computed with a prefix sum, then they are written concurrently
+// at their offset. The bytes are identical to the sequential serialization, used below the
+// threshold. Chunks of non random access containers are found by walking the container once.
+//
+// These functions must not be called from the thread pool, and the elements must not hold
+// interned strings (the interning scope is per thread).
+
+constexpr size_t parallel_serialization_threshold = 1 << 14;
+
+template <class T>
+constexpr bool is_parallel_serializable =
+    std::is_same_v<serial_tag_of<T>, serial_tag::array> ||
+    std::is_same_v<serial_tag_of<T>, serial_tag::iterable>;
+
+namespace detail {
+    // Calls f(i) for each i in [0, count), on the thread pool and the calling thread,
+    // and waits for all of them. The first exception thrown is rethrown.
+    template <class F>
+    void parallel_for(int const count, F const& f) {
+        auto mutex = std::mutex{};
+        auto done = std::condition_variable{};
+        int remaining = count - 1;
+        auto error = std::exception_ptr{};
+
+        auto const run = [&] (int const i) {
+            try { f(i); }
+            catch (...) {
+                auto lock = std::lock_guard{ mutex };
+                if (!error) error = std::current_exception();
+            }
+        };
+        for (int i = 1; i < count; ++i) {
+            thread_pool.post([&, i] {
+                run(i);
+                auto lock = std::lock_guard{ mutex };
+                if (--remaining == 0) done.notify_one();
+            });
+        }
+        run(0);
+
+        auto lock = std::unique_lock{ mutex };
+        done.wait(lock, [&] { return remaining == 0; });
+        if (error) std::rethrow_exception(error);
+    }
+
+    template <class T>
+    struct parallel_chunk {
+        decltype(std::begin(std::declval<T const&>())) first, last;
+        size_t count;
+    };
+
+    // Splits 'val' in one chunk per thread, of similar counts.
+    template <class T>
+    std::vector<parallel_chunk<T>> parallel_chunks(T const& val) {
+        size_t const count = std::size(val);
+        size_t const chunk_count = std::min<size_t>(thread_pool.size() + 1, count);
+
+        auto chunks = std::vector<parallel_chunk<T>>(chunk_count);
+        auto it = std::begin(val);
+        for (size_t i = 0; i < chunk_count; ++i) {
+            chunks[i].count = count / chunk_count + (i < count % chunk_count);
+            chunks[i].first = it;
+            std::advance(it, chunks[i].count);
+            chunks[i].last = it;
+        }
+        return chunks;
+    }
+
+    template <class T>
+    using parallel_element_t = std::remove_cv_t<std::remove_reference_t<
+        decltype(*std::begin(std::declval<T const&>()))
+    >>;
+
+    template <class T>
+    int chunk_serialized_size(parallel_chunk<T> const& chunk) noexcept {
+        using element_t = parallel_element_t<T>;
+        if constexpr (has_static_serialized_size<element_t>) {
+            return static_serialized_size<element_t> * static_cast<int>(chunk.count);
+        }
+        else {
+            int size = 0;
+            for (auto it = chunk.first; it != chunk.last; ++it) size += ::nabu::serialized_size(*it);
+            return size;
+        }
+    }
+
+    template <class T>
+    void serialize_chunk(buffer_span& span, parallel_chunk<T> const& chunk) {
+        using element_t = parallel_element_t<T>;
+        if constexpr (std::is_same_v<serial_tag_of<T>, serial_tag::array> &&
+                      (has_wire_layout<element_t> || is_byte_swapped<element_t>)) {
+            auto const size = chunk.count * sizeof(element_t);
+            if (size == 0) return;
+            memcpy(span.begin, &*chunk.first, size);
+            if constexpr (is_byte_swapped<element_t>) byte_swap_array<sizeof(element_t)>(span.begin, chunk.count);
+            span.begin += size;
+        }
+        else for (auto it = chunk.first; it != chunk.last; ++it) {
+            ::nabu::serialize(span, *it);
+        }
+    }
+
+    // Returns the offset of each chunk from the first one, and their total size.
+    template <class T>
+    std::vector<int> chunk_offsets(std::vector<parallel_chunk<T>> const& chunks, int& total) {
+        auto offsets = std::vector<int>(chunks.size());
+        if constexpr (has_static_serialized_size<parallel_element_t<T>>) {
+            for (size_t i = 0; i < chunks.size(); ++i) offsets[i] = chunk_serialized_size(chunks[i]);
+        }
+        else {
+            parallel_for(static_cast<int>(chunks.size()), [&] (int const i) {
+                offsets[i] = chunk_serialized_size(chunks[i]);
+            });
+        }
+
+        total = 0;
+        for (auto& offset : offsets) total += std::exchange(offset, total);
+        return offsets;
+    }
+
+    template <class T>
+    void parallel_serialize(buffer_span& span, T const& val,
+                            std::vector<parallel_chunk<T>> const& chunks, std::vector<int> const& offsets, int const total) {
+        serialize_count(span, std::size(val), count_encoding_of<T>{});
+        parallel_for(static_cast<int>(chunks.size()), [&] (int const i) {
+            auto chunk_span = buffer_span{ span.begin + offsets[i], span.end };
+            serialize_chunk(chunk_span, chunks[i]);
+        });
+        span.begin += total;
+    }
+}
+
+// Returns the serialized size of 'val', like serialized_size.
+
+template <class T>
+int parallel_serialized_size(T const& val) {
+    static_assert(is_parallel_serializable<T>, "[T] must have the array or iterable serial tag");
+    if (std::size(val) < parallel_serialization_threshold || thread_pool.size() == 0)
+        return serialized_size(val);
+
+    int total;
+    detail::chunk_offsets(detail::parallel_chunks(val), total);
+    return serialized_count_size(std::size(val), count_encoding_of<T>{}) + total;
+}
+
+// Serializes 'val' into 'span', like serialize, try_serialize and throw_serialize.
+// The checked versions size the container first.
+
+template <class T>
+void parallel_serialize(buffer_span& span, T const& val) {
+    static_assert(is_parallel_serializable<T>, "[T] must have the array or iterable serial tag");
+    if (std::size(val) < parallel_serialization_threshold || thread_pool.size() == 0)
+        return serialize(span, val);
+
+    int total;
+    auto const chunks  = detail::parallel_chunks(val);
+    auto const offsets = detail::chunk_offsets(chunks, total);
+    detail::parallel_serialize(span, val, chunks, offsets, total);
+}
+
+template <class T>
+bool parallel_try_serialize(buffer_span& span, T const& val) {
+    static_assert(is_parallel_serializable<T>, "[T] must have the array or iterable serial tag");
+    if (std::size(val) < parallel_serialization_threshold || thread_pool.size() == 0)
+        return try_serialize(span, val);
+
+    int total;
+    auto const chunks  = detail::parallel_chunks(val);
+    auto const offsets = detail::chunk_offsets(chunks, total);
+    if (span.size() < serialized_count_size(std::size(val), count_encoding_of<T>{}) + total)
+        return false;
+
+    detail::parallel_serialize(span, val, chunks, offsets, total);
+    return true;
+}
+
+template <class T>
+void parallel_throw_serialize(buffer_span& span, T const& val) {
+    if (!parallel_try_serialize(span, val)) throw write_buffer_overflow{ fmt::format(
+        "Tried to serialize an object of type '{}' of size {} in a too small span of size {}",
+        name_of<T>(), parallel_serialized_size(val), span.size() )};
+}
+
+} // nabu
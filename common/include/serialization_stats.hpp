@@ -0,0 +1,128 @@
+#pragma once
+
+#include <serialization.hpp>
+#include <logger.hpp>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+
+
+namespace nabu {
+
+// Serialization size accounting, enabled by the SERIALIZATION_STATS CMake option
+// (NABU_SERIALIZATION_STATS). It records the bytes written per type, and per field index
+// of the aggregates, into the global 'serialization_stats' :
+//
+//   - objects written into an instrumented_stream, which otherwise acts as a throw_stream
+//   - messages serialized by msg::parser, through record_serialization
+//
+// The report is logged by the 'serialization_stats' terminal command and at shutdown.
+// When disabled, instrumented_stream is throw_stream and record_serialization does nothing.
+
+#if defined(NABU_SERIALIZATION_STATS)
+
+class serialization_stats_type {
+public:
+    struct entry {
+        int64_t count = 0;
+        int64_t bytes = 0;
+    };
+
+    struct field_entry : entry {
+        std::string type;
+    };
+
+    serialization_stats_type() = default;
+    ~serialization_stats_type();
+
+    serialization_stats_type(serialization_stats_type&&) = delete;
+
+    void add(std::string const& type, int bytes);
+    void add_field(std::string const& type, int index, std::string const& field_type, int bytes);
+
+    entry type_stats(std::string const& type) const;
+    field_entry field_stats(std::string const& type, int index) const;
+
+    // The types sorted by total bytes, each followed by it's fields.
+    std::string report() const;
+    void clear();
+private:
+    mutable std::mutex mutex_;
+    std::map<std::string, entry> types_;
+    std::map<std::pair<std::string, int>, field_entry> fields_;
+};
+
+NABU_DECLARE_GLOBAL(serialization_stats_type, serialization_stats);
+
+namespace detail {
+    // Trivial aggregates are recorded per field too, with their packed size, if att can
+    // decompose them.
+    template <class T>
+    constexpr bool has_recorded_fields_impl() {
+        if constexpr (std::is_class_v<T> && !is_continuous_iterable<T> && att::is_aggregate<T>)
+            return std::is_same_v<serial_tag_of<T>, serial_tag::aggregate> ||
+                  (std::is_same_v<serial_tag_of<T>, serial_tag::trivial> && is_decomposable<T>);
+        else return false;
+    }
+
+    template <class T>
+    constexpr bool has_recorded_fields = has_recorded_fields_impl<T>();
+
+    template <class T>
+    void record_serialization(T const& val, int const size) {
+        serialization_stats.add(detail::name_of<T>, size);
+        if constexpr (has_recorded_fields<T>) {
+            int index = 0;
+            std::apply([&index] (auto const&...fields) {
+                (..., [&index] (auto const& field) {
+                    using field_t = std::remove_cv_t<std::remove_reference_t<decltype(field)>>;
+                    auto const field_size = ::nabu::serialized_size(field);
+                    serialization_stats.add_field(detail::name_of<T>, index++, detail::name_of<field_t>, field_size);
+                    if constexpr (has_recorded_fields<field_t>) record_serialization(field, field_size);
+                }(fields));
+            }, att::as_tuple(val));
+        }
+    }
+}
+
+// Records the serialized size of 'val', and of it's fields if it's an aggregate.
+
+template <class T>
+void record_serialization(T const& val) {
+    detail::record_serialization(val, serialized_size(val));
+}
+
+namespace stream_policy {
+    struct instrumented {};
+}
+
+using instrumented_stream = basic_stream<stream_policy::instrumented>;
+
+// instrumented_stream operations throw on overflow, like throw_stream.
+
+template <class T>
+instrumented_stream& operator<<(instrumented_stream& stream, T const& val) {
+    auto const begin = stream.begin;
+    throw_serialize(stream, val);
+    detail::record_serialization(val, static_cast<int>(stream.begin - begin));
+    return stream;
+}
+
+template <class T>
+instrumented_stream& operator>>(instrumented_stream& stream, T& val) {
+    throw_deserialize(stream, val);
+    return stream;
+}
+
+#else
+
+using instrumented_stream = throw_stream;
+
+template <class T>
+void record_serialization(T const&) noexcept {}
+
+#endif
+
+} // nabu
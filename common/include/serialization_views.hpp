@@ -0,0 +1,288 @@
+#pragma once
+
+#include <serialization_base.hpp>
+#include <string_view>
+#include <vector>
+#include <string>
+
+
+namespace nabu {
+
+// Views deserialize as pointers in the buffer, without copying nor allocating.
+// They are only valid while the deserialized buffer is alive and unchanged.
+// Their wire format is the same as their owning counterpart, so a message can be
+// sent with std::string and received with std::string_view.
+//
+//   - std::basic_string_view<Char> : std::basic_string<Char>.
+//   - array_view<T> :                std::vector<T>, with T trivial.
+//   - iterable_view<T> :             std::vector<T>, or any iterable of T. Elements are
+//                                    deserialized lazily while iterating.
+
+// array_view<T> does not require the buffer to be aligned for T, so elements are copied on access.
+// The elements are in the wire format : on big-endian hosts they are byte-swapped on access,
+// and only containers of types having the wire layout can be viewed.
+
+template <class T>
+class array_view {
+    static_assert(std::is_same_v<serial_tag_of<T>, serial_tag::trivial>, "[T] must have the trivial serial tag");
+    static_assert(!has_padding<T>, "[T] is serialized with the packed layout and can't be viewed");
+
+    std::byte const* data_;
+    size_t size_;
+public:
+    class iterator {
+        std::byte const* ptr_;
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type        = T;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = void;
+        using reference         = T;
+
+        explicit iterator(std::byte const* ptr) noexcept : ptr_{ ptr } {}
+
+        T operator*() const noexcept {
+            T val;
+            if constexpr (has_wire_layout<T>) {
+                memcpy(&val, ptr_, sizeof(T));
+            }
+            else {
+                auto span = buffer_span{ const_cast<std::byte*>(ptr_), const_cast<std::byte*>(ptr_) + sizeof(T) };
+                deserialize(span, val);
+            }
+            return val;
+        }
+        iterator& operator++() noexcept { ptr_ += sizeof(T); return *this; }
+        iterator  operator++(int) noexcept { auto it = *this; ++*this; return it; }
+
+        bool operator==(iterator rhs) const noexcept { return ptr_ == rhs.ptr_; }
+        bool operator!=(iterator rhs) const noexcept { return ptr_ != rhs.ptr_; }
+    };
+
+    array_view() noexcept :
+        data_{ nullptr }, size_{ 0 } {}
+
+    array_view(std::byte const* const data, size_t const size) noexcept :
+        data_{ data }, size_{ size } {}
+
+    template <class Container, class = std::enable_if_t<
+        is_continuous_iterable<Container> &&
+        std::is_same_v<mutable_continuous_iterable_type<Container const>, T> &&
+        has_wire_layout<T>
+    >>
+    array_view(Container const& container) noexcept :
+        data_{ reinterpret_cast<std::byte const*>(std::data(container)) },
+        size_{ std::size(container) } {}
+
+    size_t size()  const noexcept { return size_; }
+    bool   empty() const noexcept { return size_ == 0; }
+
+    std::byte const* bytes() const noexcept { return data_; }
+
+    T operator[](size_t const i) const noexcept {
+        return *iterator{ data_ + i * sizeof(T) };
+    }
+
+    iterator begin() const noexcept { return iterator{ data_ }; }
+    iterator end()   const noexcept { return iterator{ data_ + size_ * sizeof(T) }; }
+};
+
+// iterable_view<T> references 'size()' serialized T.
+
+template <class T>
+class iterable_view {
+    buffer_span span_;
+    size_t size_;
+public:
+    class iterator {
+        buffer_span span_;
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type        = T;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = void;
+        using reference         = T;
+
+        explicit iterator(buffer_span const& span) noexcept : span_{ span } {}
+
+        T operator*() const {
+            auto s = span_;
+            T val;
+            deserialize(s, val);
+            return val;
+        }
+        iterator& operator++() noexcept {
+            span_.begin += serialized_size(span_, type_tag<T>{});
+            return *this;
+        }
+        bool operator==(iterator const& rhs) const noexcept { return span_.begin == rhs.span_.begin; }
+        bool operator!=(iterator const& rhs) const noexcept { return span_.begin != rhs.span_.begin; }
+    };
+
+    iterable_view() noexcept :
+        span_{ nullptr, nullptr }, size_{ 0 } {}
+
+    // 'span' must contain exactly 'size' serialized T.
+    iterable_view(buffer_span const& span, size_t const size) noexcept :
+        span_{ span }, size_{ size } {}
+
+    size_t size()  const noexcept { return size_; }
+    bool   empty() const noexcept { return size_ == 0; }
+
+    buffer_span const& bytes() const noexcept { return span_; }
+
+    iterator begin() const noexcept { return iterator{ span_ }; }
+    iterator end()   const noexcept { return iterator{ buffer_span{ span_.end, span_.end } }; }
+};
+
+// Views use the count encoding of their owning counterpart.
+
+template <class Char, class Traits>
+struct serial_traits<std::basic_string_view<Char, Traits>> :
+    serial_traits<std::basic_string<Char, Traits>> {};
+
+template <class T>
+struct serial_traits<array_view<T>> : serial_traits<std::vector<T>> {};
+
+template <class T>
+struct serial_traits<iterable_view<T>> : serial_traits<std::vector<T>> {};
+
+namespace detail {
+    // Reads the count and the data size of a view of T elements, without advancing 'span'.
+    // Returns false if the span cannot contain them.
+    template <class View, class T>
+    bool read_view_header(buffer_span const& span, size_t& count, int& count_size, size_t& data_size) noexcept {
+        count_size = serialized_count_size(span, count, count_encoding_of<View>{});
+        if (count_size == invalid_serialized_size) return false;
+
+        data_size = count * sizeof(T);
+        return static_cast<size_t>(span.size() - count_size) >= data_size;
+    }
+
+    template <class T>
+    int iterable_view_data_size(buffer_span const& span, size_t const count) noexcept {
+        auto s = span;
+        for (size_t i = 0; i < count; ++i) {
+            int const size = serialized_size(s, type_tag<T>{});
+            if (size == invalid_serialized_size) return invalid_serialized_size;
+            s.begin += size;
+        }
+        return s.begin - span.begin;
+    }
+}
+
+// Implementation for std::basic_string_view<Char>.
+
+template <class Char, class Traits>
+constexpr int custom_serialized_size(std::basic_string_view<Char, Traits> const& view) noexcept {
+    using view_t = std::basic_string_view<Char, Traits>;
+    return serialized_count_size(view.size(), count_encoding_of<view_t>{}) + view.size() * sizeof(Char);
+}
+
+template <class Char, class Traits>
+int custom_serialized_size(buffer_span const& span, type_tag<std::basic_string_view<Char, Traits>>) noexcept {
+    size_t count, data_size;
+    int count_size;
+    if (!detail::read_view_header<std::basic_string_view<Char, Traits>, Char>(span, count, count_size, data_size))
+        return invalid_serialized_size;
+    return count_size + static_cast<int>(data_size);
+}
+
+template <class Char, class Traits>
+void custom_serialize(buffer_span& span, std::basic_string_view<Char, Traits> const& view) {
+    using view_t = std::basic_string_view<Char, Traits>;
+    serialize_count(span, view.size(), count_encoding_of<view_t>{});
+    memcpy(span.begin, view.data(), view.size() * sizeof(Char));
+    span.begin += view.size() * sizeof(Char);
+}
+
+template <class Char, class Traits>
+void custom_deserialize(buffer_span& span, std::basic_string_view<Char, Traits>& view) {
+    using view_t = std::basic_string_view<Char, Traits>;
+    auto const count = deserialize_count(span, count_encoding_of<view_t>{});
+    view = view_t{ reinterpret_cast<Char const*>(span.begin), count };
+    span.begin += count * sizeof(Char);
+}
+
+// Implementation for array_view<T>.
+
+template <class T>
+constexpr int custom_serialized_size(array_view<T> const& view) noexcept {
+    return serialized_count_size(view.size(), count_encoding_of<array_view<T>>{}) + view.size() * sizeof(T);
+}
+
+template <class T>
+int custom_serialized_size(buffer_span const& span, type_tag<array_view<T>>) noexcept {
+    size_t count, data_size;
+    int count_size;
+    if (!detail::read_view_header<array_view<T>, T>(span, count, count_size, data_size))
+        return invalid_serialized_size;
+    return count_size + static_cast<int>(data_size);
+}
+
+template <class T>
+void custom_serialize(buffer_span& span, array_view<T> const& view) {
+    serialize_count(span, view.size(), count_encoding_of<array_view<T>>{});
+    memcpy(span.begin, view.bytes(), view.size() * sizeof(T));
+    span.begin += view.size() * sizeof(T);
+}
+
+template <class T>
+void custom_deserialize(buffer_span& span, array_view<T>& view) {
+    auto const count = deserialize_count(span, count_encoding_of<array_view<T>>{});
+    view = array_view<T>{ span.begin, count };
+    span.begin += count * sizeof(T);
+}
+
+// Implementation for iterable_view<T>.
+
+template <class T>
+int custom_serialized_size(iterable_view<T> const& view) noexcept {
+    return serialized_count_size(view.size(), count_encoding_of<iterable_view<T>>{}) + view.bytes().size();
+}
+
+template <class T>
+int custom_serialized_size(buffer_span const& span, type_tag<iterable_view<T>>) noexcept {
+    size_t count;
+    int const count_size = serialized_count_size(span, count, count_encoding_of<iterable_view<T>>{});
+    if (count_size == invalid_serialized_size) return invalid_serialized_size;
+
+    int const data_size = detail::iterable_view_data_size<T>(
+        buffer_span{ span.begin + count_size, span.end }, count);
+    if (data_size == invalid_serialized_size) return invalid_serialized_size;
+
+    return count_size + data_size;
+}
+
+template <class T>
+void custom_serialize(buffer_span& span, iterable_view<T> const& view) {
+    serialize_count(span, view.size(), count_encoding_of<iterable_view<T>>{});
+    auto const& bytes = view.bytes();
+    memcpy(span.begin, bytes.begin, bytes.size());
+    span.begin += bytes.size();
+}
+
+template <class T>
+void custom_deserialize(buffer_span& span, iterable_view<T>& view) {
+    auto const count = deserialize_count(span, count_encoding_of<iterable_view<T>>{});
+    int const size = detail::iterable_view_data_size<T>(span, count);
+    view = iterable_view<T>{ buffer_span{ span.begin, span.begin + size }, count };
+    span.begin += size;
+}
+
+template <class T>
+bool custom_try_deserialize(buffer_span& span, iterable_view<T>& view) {
+    size_t count;
+    int const count_size = serialized_count_size(span, count, count_encoding_of<iterable_view<T>>{});
+    if (count_size == invalid_serialized_size) return false;
+
+    auto const data = buffer_span{ span.begin + count_size, span.end };
+    int const size = detail::iterable_view_data_size<T>(data, count);
+    if (size == invalid_serialized_size) return false;
+
+    view = iterable_view<T>{ buffer_span{ data.begin, data.begin + size }, count };
+    span.begin = data.begin + size;
+    return true;
+}
+
+} // nabu
@@ -2,6 +2,8 @@
 #pragma once
 
 #include <reactor.hpp>
+#include <condition_variable>
+#include <thread>
 
 
 namespace nabu {
@@ -13,6 +15,9 @@ public:
 
 	thread_pool_type(thread_pool_type&&) = delete;
 
+	// The number of worker threads.
+	int size() const noexcept { return static_cast<int>(threads_.size()); }
+
 	template <class F>
 	void post(F&& f);
 
@@ -22,7 +27,7 @@ public:
 private:
 	bool done_;
 	std::vector<std::thread> threads_;
-	std::queue<std::function<void()>> functors_;
+	std::queue<fu2::unique_function<void()>> functors_;
 	std::condition_variable cond_var_;
 	std::mutex mutex_;
 };
@@ -34,7 +39,7 @@ template <class F>
 void thread_pool_type::post(F&& f) {
 	{
 		auto lock = std::lock_guard{ mutex_ };
-		functors_.emplace_back([std::forward<F>(f)]{
+		functors_.emplace([f = std::forward<F>(f)] () mutable {
 			try { f(); }
 			catch (...) {
 				reactor.sync_task([exception = std::current_exception()]{
@@ -50,16 +55,16 @@ template <class F, class Continuation>
 void thread_pool_type::post(F&& f, Continuation&& f2) {
 	{
 		auto lock = std::lock_guard{ mutex_ };
-		functors_.emplace_back([std::forward<F>(f)] {
+		functors_.emplace([f = std::forward<F>(f), f2 = std::forward<Continuation>(f2)] () mutable {
 			try {
 				if constexpr (takes_argument<Continuation>) {
-					reactor.sync_task([arg = f(), f2 = std::forward<Continuation>(f2)]{
+					reactor.sync_task([arg = f(), f2 = std::move(f2)] () mutable {
 						f2(std::move(arg));
 					});
 				}
 				else {
 					f();
-					reactor.sync_task(std::forward<Continuation>(f2));
+					reactor.sync_task(std::move(f2));
 				}
 			}
 			catch (...) {
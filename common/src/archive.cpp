@@ -0,0 +1,161 @@
+#include <archive.hpp>
+#include <algorithm>
+#include <fstream>
+#include <utility>
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+
+namespace nabu {
+
+// archive_writer
+
+std::vector<std::byte> archive_writer::finish() const {
+    auto index = index_;
+    std::sort(index.begin(), index.end(), [] (auto const& lhs, auto const& rhs) {
+        return lhs.key < rhs.key;
+    });
+    auto const duplicate = std::adjacent_find(index.begin(), index.end(), [] (auto const& lhs, auto const& rhs) {
+        return lhs.key == rhs.key;
+    });
+    if (duplicate != index.end()) throw archive_error{ fmt::format(
+        "Tried to write an archive with the duplicated key {}", duplicate->key )};
+
+    auto const header = detail::archive_header{ detail::archive_magic, detail::archive_version };
+    int const size = serialized_size(header) + serialized_size(index) + static_cast<int>(data_.size());
+
+    auto bytes = std::vector<std::byte>(size);
+    auto stream = throw_stream{ bytes };
+    stream << header << index;
+    memcpy(stream.begin, data_.data(), data_.size());
+    return bytes;
+}
+
+void archive_writer::save(std::string const& path) const {
+    auto const bytes = finish();
+    auto file = std::ofstream{ path, std::ios::binary | std::ios::trunc };
+    file.write(reinterpret_cast<char const*>(bytes.data()), bytes.size());
+    if (!file) throw archive_error{ fmt::format("Failed to write the archive '{}'", path) };
+}
+
+// archive_view
+
+archive_view::archive_view(buffer_span const& bytes) :
+    data_{ nullptr, nullptr }
+{
+    auto span = bytes;
+    detail::archive_header header;
+    if (!try_deserialize(span, header) || header.magic != detail::archive_magic)
+        throw archive_error{ "Invalid archive header" };
+    if (header.version != detail::archive_version) throw archive_error{ fmt::format(
+        "Unsupported archive version {}, expected {}", header.version, detail::archive_version )};
+    if (!try_deserialize(span, index_))
+        throw archive_error{ "Invalid archive index" };
+
+    // Entries are found with a binary search : keys must be sorted and unique.
+    for (size_t i = 1; i < index_.size(); ++i) {
+        if (index_[i - 1].key >= index_[i].key) throw archive_error{ "Invalid archive index" };
+    }
+
+    data_ = span;
+}
+
+buffer_span archive_view::find(uint32_t const key) const noexcept {
+    size_t first = 0;
+    size_t last  = index_.size();
+    while (first < last) {
+        auto const middle = first + (last - first) / 2;
+        if (index_[middle].key < key) first = middle + 1;
+        else last = middle;
+    }
+    if (first == index_.size()) return { nullptr, nullptr };
+
+    auto const entry = index_[first];
+    auto const data_size = static_cast<uint64_t>(data_.size());
+    if (entry.key != key || entry.offset > data_size || entry.size > data_size - entry.offset)
+        return { nullptr, nullptr };
+
+    auto const begin = data_.begin + entry.offset;
+    return { begin, begin + entry.size };
+}
+
+// mapped_file
+
+mapped_file::mapped_file(std::string const& path) :
+    data_{ nullptr },
+    size_{ 0 }
+{
+#if defined(_WIN32)
+    auto const file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        throw archive_error{ fmt::format("Failed to open the file '{}'", path) };
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        throw archive_error{ fmt::format("Failed to get the size of the file '{}'", path) };
+    }
+    size_ = static_cast<size_t>(size.QuadPart);
+    if (size_ == 0) { CloseHandle(file); return; }
+
+    // The view keeps the mapping alive.
+    auto const mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping)
+        throw archive_error{ fmt::format("Failed to map the file '{}'", path) };
+
+    data_ = static_cast<std::byte*>(MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0));
+    CloseHandle(mapping);
+    if (!data_)
+        throw archive_error{ fmt::format("Failed to map the file '{}'", path) };
+#else
+    int const file = open(path.c_str(), O_RDONLY);
+    if (file == -1)
+        throw archive_error{ fmt::format("Failed to open the file '{}'", path) };
+
+    struct stat status;
+    if (fstat(file, &status) == -1) {
+        close(file);
+        throw archive_error{ fmt::format("Failed to get the size of the file '{}'", path) };
+    }
+    size_ = static_cast<size_t>(status.st_size);
+    if (size_ == 0) { close(file); return; }
+
+    auto const data = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+    close(file);
+    if (data == MAP_FAILED)
+        throw archive_error{ fmt::format("Failed to map the file '{}'", path) };
+    data_ = static_cast<std::byte*>(data);
+#endif
+}
+
+mapped_file::~mapped_file() {
+    if (!data_) return;
+#if defined(_WIN32)
+    UnmapViewOfFile(data_);
+#else
+    munmap(data_, size_);
+#endif
+}
+
+mapped_file::mapped_file(mapped_file&& rhs) noexcept :
+    data_{ std::exchange(rhs.data_, nullptr) },
+    size_{ std::exchange(rhs.size_, 0) } {}
+
+mapped_file& mapped_file::operator=(mapped_file&& rhs) noexcept {
+    std::swap(data_, rhs.data_);
+    std::swap(size_, rhs.size_);
+    return *this;
+}
+
+} // nabu
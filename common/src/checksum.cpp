@@ -0,0 +1,127 @@
+#include <checksum.hpp>
+#include <array>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__x86_64__)
+    #define NABU_CRC32C_X86
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+        #include <nmmintrin.h>
+        #define NABU_TARGET_SSE42
+    #else
+        #include <cpuid.h>
+        #include <nmmintrin.h>
+        #define NABU_TARGET_SSE42 [[gnu::target("sse4.2")]]
+    #endif
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+    #define NABU_CRC32C_ARM
+    #include <arm_acle.h>
+#endif
+
+
+namespace nabu {
+
+namespace {
+    constexpr uint32_t polynomial = 0x82F63B78; // Castagnoli, reflected
+
+    // Slicing-by-8 tables : tables[k][b] is the CRC of byte 'b' followed by 'k' zero bytes.
+    constexpr auto make_tables() noexcept {
+        std::array<std::array<uint32_t, 256>, 8> tables{};
+        for (uint32_t b = 0; b < 256; ++b) {
+            uint32_t crc = b;
+            for (int i = 0; i < 8; ++i) crc = (crc >> 1) ^ (polynomial & (0 - (crc & 1)));
+            tables[0][b] = crc;
+        }
+        for (uint32_t b = 0; b < 256; ++b) {
+            for (int k = 1; k < 8; ++k) {
+                auto const previous = tables[k - 1][b];
+                tables[k][b] = (previous >> 8) ^ tables[0][previous & 0xFF];
+            }
+        }
+        return tables;
+    }
+
+    constexpr auto tables = make_tables();
+
+    uint32_t crc32c_table(uint32_t crc, std::byte const* data, size_t size) noexcept {
+        for (; size >= 8; size -= 8, data += 8) {
+            uint32_t low, high;
+            memcpy(&low,  data,     4);
+            memcpy(&high, data + 4, 4);
+            low  = from_little_endian(low) ^ crc;
+            high = from_little_endian(high);
+            crc = tables[7][ low         & 0xFF] ^ tables[6][(low  >>  8) & 0xFF] ^
+                  tables[5][(low  >> 16) & 0xFF] ^ tables[4][ low  >> 24        ] ^
+                  tables[3][ high        & 0xFF] ^ tables[2][(high >>  8) & 0xFF] ^
+                  tables[1][(high >> 16) & 0xFF] ^ tables[0][ high >> 24        ];
+        }
+        for (; size > 0; --size, ++data) {
+            crc = (crc >> 8) ^ tables[0][(crc ^ static_cast<uint32_t>(*data)) & 0xFF];
+        }
+        return crc;
+    }
+
+#if defined(NABU_CRC32C_X86)
+    NABU_TARGET_SSE42
+    uint32_t crc32c_hardware(uint32_t crc, std::byte const* data, size_t size) noexcept {
+        uint64_t crc64 = crc;
+        for (; size >= 8; size -= 8, data += 8) {
+            uint64_t val;
+            memcpy(&val, data, 8);
+            crc64 = _mm_crc32_u64(crc64, val);
+        }
+        crc = static_cast<uint32_t>(crc64);
+        for (; size > 0; --size, ++data) {
+            crc = _mm_crc32_u8(crc, static_cast<uint8_t>(*data));
+        }
+        return crc;
+    }
+
+    bool cpu_has_crc32c() noexcept {
+    #if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 1);
+        return info[2] & (1 << 20);
+    #else
+        unsigned a, b, c, d;
+        return __get_cpuid(1, &a, &b, &c, &d) && (c & bit_SSE4_2);
+    #endif
+    }
+#elif defined(NABU_CRC32C_ARM)
+    uint32_t crc32c_hardware(uint32_t crc, std::byte const* data, size_t size) noexcept {
+        for (; size >= 8; size -= 8, data += 8) {
+            uint64_t val;
+            memcpy(&val, data, 8);
+            crc = __crc32cd(crc, val);
+        }
+        for (; size > 0; --size, ++data) {
+            crc = __crc32cb(crc, static_cast<uint8_t>(*data));
+        }
+        return crc;
+    }
+
+    constexpr bool cpu_has_crc32c() noexcept { return true; }
+#endif
+
+    using crc32c_function = uint32_t(*)(uint32_t, std::byte const*, size_t) noexcept;
+
+    // Chosen on first use, so that it's usable during static initialization.
+    crc32c_function crc32c_implementation() noexcept {
+#if defined(NABU_CRC32C_X86) || defined(NABU_CRC32C_ARM)
+        static crc32c_function const implementation = cpu_has_crc32c() ? &crc32c_hardware : &crc32c_table;
+        return implementation;
+#else
+        return &crc32c_table;
+#endif
+    }
+}
+
+uint32_t crc32c(uint32_t const crc, std::byte const* const data, size_t const size) noexcept {
+    return ~crc32c_implementation()(~crc, data, size);
+}
+
+bool has_hardware_crc32c() noexcept {
+    return crc32c_implementation() != &crc32c_table;
+}
+
+} // nabu
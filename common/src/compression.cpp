@@ -0,0 +1,171 @@
+#include <compression.hpp>
+#include <array>
+
+
+namespace nabu::lz {
+
+namespace {
+    constexpr int min_match   = 4;
+    constexpr int max_offset  = 0xFFFF;
+    constexpr int hash_bits   = 12;
+    constexpr int max_literal = 15;
+    constexpr int max_chain   = 16;
+
+    uint32_t read32(std::byte const* const ptr) noexcept {
+        uint32_t val;
+        memcpy(&val, ptr, sizeof(val));
+        return val;
+    }
+
+    uint32_t hash(uint32_t const val) noexcept {
+        return (val * 2654435761u) >> (32 - hash_bits);
+    }
+
+    // Lengths above 15 continue with bytes of 255, ended by a smaller byte.
+    void write_length(std::byte*& out, size_t length) noexcept {
+        for (; length >= 255; length -= 255) *out++ = std::byte{ 255 };
+        *out++ = static_cast<std::byte>(length);
+    }
+
+    bool read_length(std::byte const*& in, std::byte const* const end, size_t& length, size_t const max) noexcept {
+        for (;;) {
+            if (in == end) return false;
+            auto const byte = static_cast<size_t>(*in++);
+            length += byte;
+            if (length > max) return false;
+            if (byte != 255) return true;
+        }
+    }
+
+    void write_sequence(std::byte*& out, std::byte const* const literals, size_t const literal_count,
+                        int const offset, size_t const match_length) noexcept {
+        auto& token = *out++;
+        auto const literal_token = std::min<size_t>(literal_count, max_literal);
+        auto const match_token   = std::min<size_t>(match_length - min_match, max_literal);
+        token = static_cast<std::byte>(literal_token << 4 | match_token);
+
+        if (literal_token == max_literal) write_length(out, literal_count - max_literal);
+        memcpy(out, literals, literal_count);
+        out += literal_count;
+
+        out[0] = static_cast<std::byte>(offset & 0xFF);
+        out[1] = static_cast<std::byte>(offset >> 8);
+        out += 2;
+
+        if (match_token == max_literal) write_length(out, match_length - min_match - max_literal);
+    }
+
+    void write_last_literals(std::byte*& out, std::byte const* const literals, size_t const literal_count) noexcept {
+        auto const literal_token = std::min<size_t>(literal_count, max_literal);
+        *out++ = static_cast<std::byte>(literal_token << 4);
+
+        if (literal_token == max_literal) write_length(out, literal_count - max_literal);
+        if (literal_count == 0) return;
+        memcpy(out, literals, literal_count);
+        out += literal_count;
+    }
+}
+
+int compress(array_view<std::byte> const src, std::byte* const dst, array_view<std::byte> const dictionary) {
+    // With a dictionary, the input is the dictionary followed by 'src', and only 'src' is encoded.
+    thread_local std::vector<std::byte> window;
+    std::byte const* input = src.bytes();
+    int const start = static_cast<int>(dictionary.size());
+    int const end   = start + static_cast<int>(src.size());
+    if (!dictionary.empty()) {
+        window.resize(end);
+        memcpy(window.data(), dictionary.bytes(), dictionary.size());
+        memcpy(window.data() + start, src.bytes(), src.size());
+        input = window.data();
+    }
+
+    // Positions are chained by hash : the longest of the 'max_chain' most recent candidates is kept.
+    thread_local std::vector<int> chain;
+    chain.resize(end);
+    auto table = std::array<int, 1 << hash_bits>{};
+    table.fill(-1);
+    auto const insert = [&table, input] (int const i) {
+        auto& head = table[hash(read32(input + i))];
+        chain[i] = head;
+        head = i;
+    };
+    for (int i = std::max(0, start - max_offset); i + min_match <= start; ++i) insert(i);
+
+    auto out = dst;
+    int anchor = start;
+    int pos = start;
+    while (pos + min_match <= end) {
+        auto const sequence = read32(input + pos);
+        int match = -1;
+        int length = 0;
+        int candidate = table[hash(sequence)];
+        for (int n = 0; n < max_chain && candidate >= 0 && pos - candidate <= max_offset; ++n) {
+            int const next = chain[candidate];
+            if (read32(input + candidate) == sequence) {
+                int l = min_match;
+                while (pos + l < end && input[candidate + l] == input[pos + l]) ++l;
+                if (l > length) { match = candidate; length = l; }
+            }
+            candidate = next;
+        }
+
+        if (match < 0) {
+            insert(pos++);
+            continue;
+        }
+
+        write_sequence(out, input + anchor, pos - anchor, pos - match, length);
+        for (int const next = pos + length; pos < next; ++pos) {
+            if (pos + min_match <= end) insert(pos);
+        }
+        anchor = pos;
+    }
+    write_last_literals(out, input + anchor, end - anchor);
+
+    return static_cast<int>(out - dst);
+}
+
+bool decompress(array_view<std::byte> const src, std::byte* const dst, int const dst_size,
+                array_view<std::byte> const dictionary) noexcept {
+    auto in = src.bytes();
+    auto const in_end = in + src.size();
+    auto const dict_size = dictionary.size();
+    auto const size = static_cast<size_t>(dst_size);
+    size_t pos = 0;
+
+    for (;;) {
+        if (in == in_end) return false;
+        auto const token = static_cast<size_t>(*in++);
+
+        size_t literal_count = token >> 4;
+        if (literal_count == max_literal && !read_length(in, in_end, literal_count, size)) return false;
+        if (literal_count > static_cast<size_t>(in_end - in) || literal_count > size - pos) return false;
+        if (literal_count > 0) memcpy(dst + pos, in, literal_count);
+        in  += literal_count;
+        pos += literal_count;
+
+        // The last sequence only has literals.
+        if (in == in_end) return pos == size;
+
+        if (in_end - in < 2) return false;
+        auto const offset = static_cast<size_t>(in[0]) | static_cast<size_t>(in[1]) << 8;
+        in += 2;
+        if (offset == 0 || offset > pos + dict_size) return false;
+
+        size_t length = token & max_literal;
+        if (length == max_literal && !read_length(in, in_end, length, size)) return false;
+        length += min_match;
+        if (length > size - pos) return false;
+
+        // Matches can overlap themselves, and start in the dictionary.
+        if (offset <= pos && offset >= length) {
+            memcpy(dst + pos, dst + pos - offset, length);
+            pos += length;
+        }
+        else for (size_t i = 0; i < length; ++i, ++pos) {
+            dst[pos] = offset <= pos ? dst[pos - offset] : dictionary.bytes()[dict_size + pos - offset];
+        }
+    }
+}
+
+} // nabu::lz
@@ -0,0 +1,77 @@
+#include <serialization_stats.hpp>
+
+#if defined(NABU_SERIALIZATION_STATS)
+
+#include <algorithm>
+#include <vector>
+
+
+namespace nabu {
+
+serialization_stats_type::~serialization_stats_type() {
+    if (!types_.empty()) logger.info("{}", report());
+}
+
+void serialization_stats_type::add(std::string const& type, int const bytes) {
+    auto lock = std::lock_guard{ mutex_ };
+    auto& entry = types_[type];
+    entry.count += 1;
+    entry.bytes += bytes;
+}
+
+void serialization_stats_type::add_field(std::string const& type, int const index,
+                                         std::string const& field_type, int const bytes) {
+    auto lock = std::lock_guard{ mutex_ };
+    auto& entry = fields_[{ type, index }];
+    if (entry.count == 0) entry.type = field_type;
+    entry.count += 1;
+    entry.bytes += bytes;
+}
+
+serialization_stats_type::entry serialization_stats_type::type_stats(std::string const& type) const {
+    auto lock = std::lock_guard{ mutex_ };
+    auto const it = types_.find(type);
+    return it != types_.end() ? it->second : entry{};
+}
+
+serialization_stats_type::field_entry serialization_stats_type::field_stats(std::string const& type, int const index) const {
+    auto lock = std::lock_guard{ mutex_ };
+    auto const it = fields_.find({ type, index });
+    return it != fields_.end() ? it->second : field_entry{};
+}
+
+std::string serialization_stats_type::report() const {
+    auto lock = std::lock_guard{ mutex_ };
+
+    auto types = std::vector<std::pair<std::string, entry>>(types_.begin(), types_.end());
+    std::stable_sort(types.begin(), types.end(), [] (auto const& lhs, auto const& rhs) {
+        return lhs.second.bytes > rhs.second.bytes;
+    });
+
+    auto report = std::string{ "Serialization stats :" };
+    for (auto const& [type, entry] : types) {
+        report += fmt::format("\n  {} : {} bytes in {} objects ({:.1f} per object)",
+            type, entry.bytes, entry.count, static_cast<double>(entry.bytes) / entry.count);
+
+        // The fields of a type are contiguous in 'fields_', ordered by index.
+        for (auto it = fields_.lower_bound({ type, 0 }); it != fields_.end() && it->first.first == type; ++it) {
+            auto const& field = it->second;
+            report += fmt::format("\n    field {} ({}) : {} bytes ({:.1f}%)",
+                it->first.second, field.type, field.bytes,
+                entry.bytes ? 100.0 * field.bytes / entry.bytes : 0.0);
+        }
+    }
+    return report;
+}
+
+void serialization_stats_type::clear() {
+    auto lock = std::lock_guard{ mutex_ };
+    types_.clear();
+    fields_.clear();
+}
+
+NABU_IMPLEMENT_GLOBAL(serialization_stats);
+
+} // nabu
+
+#endif
@@ -0,0 +1,52 @@
+#include <net/socket.hpp>
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <winsock2.h>
+#else
+    #include <sys/socket.h>
+    #include <sys/uio.h>
+    #include <cerrno>
+#endif
+
+
+namespace nabu::net::detail {
+
+std::ptrdiff_t write_segments(sf::SocketHandle const handle, buffer_span const* const segments, int const count) noexcept {
+#if defined(_WIN32)
+    WSABUF buffers[max_write_segments];
+    for (int i = 0; i < count; ++i) {
+        buffers[i].buf = reinterpret_cast<CHAR*>(segments[i].begin);
+        buffers[i].len = static_cast<ULONG>(segments[i].size());
+    }
+    DWORD written = 0;
+    if (WSASend(handle, buffers, count, &written, 0, nullptr, nullptr) == SOCKET_ERROR)
+        return WSAGetLastError() == WSAEWOULDBLOCK ? 0 : -1;
+    return written;
+#else
+    iovec buffers[max_write_segments];
+    for (int i = 0; i < count; ++i) {
+        buffers[i].iov_base = segments[i].begin;
+        buffers[i].iov_len  = static_cast<size_t>(segments[i].size());
+    }
+    msghdr message{};
+    message.msg_iov    = buffers;
+    message.msg_iovlen = count;
+
+    // sendmsg is writev with flags : a closed connection must not raise SIGPIPE.
+    #if defined(MSG_NOSIGNAL)
+        constexpr int flags = MSG_NOSIGNAL;
+    #else
+        constexpr int flags = 0; // SFML sets SO_NOSIGPIPE instead.
+    #endif
+    while (true) {
+        auto const written = sendmsg(handle, &message, flags);
+        if (written >= 0) return written;
+        if (errno == EINTR) continue;
+        return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+    }
+#endif
+}
+
+} // nabu::net::detail
@@ -1,5 +1,6 @@
 
 #include <thread_pool.hpp>
+#include <algorithm>
 
 
 namespace nabu {
@@ -10,7 +11,7 @@ thread_pool_type::thread_pool_type(int const nb_threads) :
 	NABU_ASSERT(nb_threads > 0, "The thread pool must have at least one worker");
 
 	threads_.reserve(nb_threads);
-	for (auto i = 0; i < nb_thread; ++i) {
+	for (auto i = 0; i < nb_threads; ++i) {
 		threads_.emplace_back([this] {
 			auto f = fu2::unique_function<void()>{};
 			while (true) {
@@ -42,7 +43,7 @@ thread_pool_type::~thread_pool_type() {
 	threads_.clear();
 }
 
-NABU_IMPLEMENT_GLOBAL(thread_pool, std::thread::hardware_concurrency() - 1);
+NABU_IMPLEMENT_GLOBAL(thread_pool, std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1));
 
 } // nabu
 
@@ -0,0 +1,104 @@
+#include <catch.hpp>
+#include <archive.hpp>
+#include <cstdio>
+
+
+namespace {
+    struct room_t {
+        int id;
+        std::string name;
+        std::vector<int> tiles;
+    };
+
+    bool operator==(room_t const& lhs, room_t const& rhs) {
+        return lhs.id == rhs.id && lhs.name == rhs.name && lhs.tiles == rhs.tiles;
+    }
+
+    struct room_view_t {
+        int id;
+        std::string_view name;
+        nabu::array_view<int> tiles;
+    };
+
+    nabu::archive_writer make_archive() {
+        auto writer = nabu::archive_writer{};
+        writer.add(30, room_t{ 3, "treasury", { 7, 8, 9 } });
+        writer.add(10, room_t{ 1, "entrance", { 1, 2, 3 } });
+        writer.add(20, room_t{ 2, "corridor", {} });
+        writer.add(40, std::string{ "level name" });
+        return writer;
+    }
+}
+
+TEST_CASE("archive random access", "[archive]") {
+    using namespace nabu;
+    auto bytes = make_archive().finish();
+    auto const archive = archive_view{ buffer_span{ bytes.data(), bytes.data() + bytes.size() } };
+    REQUIRE(archive.size() == 4);
+
+    room_t room;
+    REQUIRE(archive.try_read(20, room));
+    REQUIRE(room == room_t{ 2, "corridor", {} });
+    REQUIRE(archive.try_read(30, room));
+    REQUIRE(room == room_t{ 3, "treasury", { 7, 8, 9 } });
+
+    std::string name;
+    archive.read(40, name);
+    REQUIRE(name == "level name");
+
+    REQUIRE(!archive.contains(0));
+    REQUIRE(!archive.contains(25));
+    REQUIRE(!archive.try_read(50, room));
+    REQUIRE_THROWS_AS(archive.read(50, room), archive_error);
+
+    // An entry must be exactly the serialized type.
+    REQUIRE(!archive.try_read(10, name));
+}
+
+TEST_CASE("archive borrowed decoding", "[archive]") {
+    using namespace nabu;
+    auto bytes = make_archive().finish();
+    auto const archive = archive_view{ buffer_span{ bytes.data(), bytes.data() + bytes.size() } };
+
+    room_view_t room;
+    REQUIRE(archive.try_read(10, room));
+    REQUIRE(room.name == "entrance");
+    REQUIRE(room.tiles.size() == 3);
+    REQUIRE(room.tiles[2] == 3);
+
+    auto const entry = archive.find(10);
+    REQUIRE(reinterpret_cast<std::byte const*>(room.name.data()) > entry.begin);
+    REQUIRE(reinterpret_cast<std::byte const*>(room.name.data()) < entry.end);
+}
+
+TEST_CASE("archive validation", "[archive]") {
+    using namespace nabu;
+    auto bytes = make_archive().finish();
+
+    auto truncated = buffer_span{ bytes.data(), bytes.data() + 10 };
+    REQUIRE_THROWS_AS(archive_view{ truncated }, archive_error);
+
+    bytes[0] = std::byte{ 0 };
+    REQUIRE_THROWS_AS(archive_view(buffer_span{ bytes.data(), bytes.data() + bytes.size() }), archive_error);
+
+    auto writer = make_archive();
+    writer.add(20, std::string{ "duplicate" });
+    REQUIRE_THROWS_AS(writer.finish(), archive_error);
+}
+
+TEST_CASE("archive mapped file", "[archive]") {
+    using namespace nabu;
+    auto const path = std::string{ "nabu_archive_test.nar" };
+    make_archive().save(path);
+    {
+        auto const file = mapped_file{ path };
+        auto const archive = archive_view{ file.bytes() };
+
+        room_t room;
+        archive.read(30, room);
+        REQUIRE(room == room_t{ 3, "treasury", { 7, 8, 9 } });
+    }
+    std::remove(path.c_str());
+
+    REQUIRE_THROWS_AS(mapped_file{ path }, archive_error);
+}
@@ -0,0 +1,99 @@
+
+#include <catch.hpp>
+#include <bit_stream.hpp>
+
+
+namespace {
+    enum class direction { north, east, south, west };
+
+    struct movement_t {
+        nabu::ranged<0, 1023> x;
+        nabu::ranged<0, 1023> y;
+        nabu::enumerated<direction, 4> facing;
+        nabu::quantized<-10, 10, 100> speed;
+        bool running;
+    };
+    struct chat_t {
+        bool whisper;
+        std::string text;
+        std::vector<nabu::ranged<-8, 7>> emotes;
+    };
+}
+
+TEST_CASE("bit stream annotations", "[bit_stream]") {
+    using namespace nabu;
+    static_assert(ranged<0, 1023>::bits == 10);
+    static_assert(ranged<-8, 7>::bits == 4);
+    static_assert(enumerated<direction, 4>::bits == 2);
+    static_assert(quantized<-10, 10, 100>::bits == 11);
+    static_assert(packed_bits<movement_t> == 10 + 10 + 2 + 11 + 1);
+    static_assert(packed_bits<chat_t> == dynamic_serialized_size);
+
+    // With byte streams, annotations are serialized as their underlying value.
+    static_assert(static_serialized_size<movement_t> == 2 * sizeof(int) + sizeof(direction) + sizeof(float) + 1);
+    auto const movement = movement_t{ 5, 1000, direction::west, 2.5f, true };
+    std::byte buffer[static_serialized_size<movement_t>];
+    auto stream = throw_stream{ buffer };
+    stream << movement;
+    auto copy = movement_t{};
+    stream = throw_stream{ buffer };
+    stream >> copy;
+    REQUIRE(copy.x == 5);
+    REQUIRE(copy.y == 1000);
+    REQUIRE(copy.facing == direction::west);
+    REQUIRE(copy.speed == 2.5f);
+    REQUIRE(copy.running);
+}
+
+TEST_CASE("bit stream packing", "[bit_stream]") {
+    using namespace nabu;
+    auto const move = movement_t{ 1000, 3, direction::west, -2.57f, true };
+    auto const chat = chat_t{ true, "hello", { -8, 0, 7 } };
+
+    std::byte buffer[64];
+    auto stream = bit_stream{ buffer };
+    stream << move << chat << move.x;
+    flush(stream);
+    REQUIRE(!stream.error);
+
+    // 34 bits for 'move', then 1 bit before aligning for 'text', 6 bytes for it,
+    // then 8 bits of count, 12 bits for 'emotes', and 10 bits for 'move.x'.
+    REQUIRE(stream.begin - buffer == 5 + 6 + 4);
+
+    movement_t move_copy;
+    chat_t chat_copy;
+    ranged<0, 1023> x;
+    auto const written = stream.begin;
+    stream = bit_stream{ buffer, written };
+    stream >> move_copy >> chat_copy >> x;
+    REQUIRE(!stream.error);
+    REQUIRE(stream.begin == written);
+
+    REQUIRE(move_copy.x == 1000);
+    REQUIRE(move_copy.y == 3);
+    REQUIRE(move_copy.facing == direction::west);
+    REQUIRE(move_copy.speed == Approx(-2.57f).margin(0.005f));
+    REQUIRE(move_copy.running);
+    REQUIRE(chat_copy.whisper);
+    REQUIRE(chat_copy.text == "hello");
+    REQUIRE(chat_copy.emotes.size() == 3);
+    REQUIRE(chat_copy.emotes[0] == -8);
+    REQUIRE(chat_copy.emotes[2] == 7);
+    REQUIRE(x == 1000);
+}
+
+TEST_CASE("bit stream failures", "[bit_stream]") {
+    using namespace nabu;
+    std::byte buffer[2];
+    auto stream = bit_stream{ buffer };
+    stream << ranged<0, 1023>{ 5 } << ranged<0, 1023>{ 6 };
+    REQUIRE(stream.error);
+
+    buffer[0] = std::byte{ 0xFF };
+    buffer[1] = std::byte{ 0 };
+    stream = bit_stream{ buffer };
+    enumerated<direction, 4> facing;
+    ranged<0, 5> small;
+    stream >> facing >> small;
+    REQUIRE(stream.error);
+}
@@ -0,0 +1,54 @@
+#include <catch.hpp>
+#include <checksum.hpp>
+
+
+TEST_CASE("crc32c", "[checksum]") {
+    using namespace nabu;
+    char const data[] = "123456789";
+    auto const bytes = reinterpret_cast<std::byte const*>(data);
+    REQUIRE(crc32c(0, bytes, 9) == 0xE3069283);
+    REQUIRE(crc32c(crc32c(0, bytes, 4), bytes + 4, 5) == 0xE3069283);
+    REQUIRE(crc32c(0, bytes, 0) == 0);
+}
+
+TEST_CASE("checksum stream", "[checksum]") {
+    using namespace nabu;
+    auto const name  = std::string{ "level 1" };
+    auto const tiles = std::vector<int>(100, 42);
+    int const size = serialized_size(name) + serialized_size(tiles) + sizeof(uint32_t);
+
+    auto buffer = std::vector<std::byte>(size);
+    auto stream = throw_stream{ buffer };
+    auto writer = checksum_stream{ stream };
+    writer << name << tiles;
+    writer.write_trailer();
+    REQUIRE(stream.is_empty());
+    REQUIRE(writer.checksum() == crc32c(0, buffer.data(), size - sizeof(uint32_t)));
+
+    SECTION("valid frame") {
+        auto in = throw_stream{ buffer };
+        auto reader = checksum_stream{ in };
+        std::string name_copy;
+        std::vector<int> tiles_copy;
+        reader >> name_copy >> tiles_copy;
+        REQUIRE(reader.read_trailer());
+        REQUIRE(tiles_copy == tiles);
+    }
+    SECTION("corrupted frame") {
+        buffer[size / 2] ^= std::byte{ 1 };
+        auto in = throw_stream{ buffer };
+        auto reader = checksum_stream{ in };
+        std::string name_copy;
+        std::vector<int> tiles_copy;
+        reader >> name_copy >> tiles_copy;
+        REQUIRE(!reader.read_trailer());
+    }
+    SECTION("truncated frame") {
+        auto in = checked_stream{ buffer.data(), size - 2 };
+        auto reader = checksum_stream{ in };
+        std::string name_copy;
+        std::vector<int> tiles_copy;
+        reader >> name_copy >> tiles_copy;
+        REQUIRE(!reader.read_trailer());
+    }
+}
@@ -0,0 +1,107 @@
+#include <catch.hpp>
+#include <compression.hpp>
+
+
+namespace {
+    struct tile_t {
+        int type;
+        int height;
+    };
+
+    bool operator==(tile_t const& lhs, tile_t const& rhs) {
+        return lhs.type == rhs.type && lhs.height == rhs.height;
+    }
+
+    using level_t = std::vector<tile_t>;
+
+    level_t make_level(int const size) {
+        auto level = level_t(size);
+        for (int i = 0; i < size; ++i) level[i] = tile_t{ i % 3, i % 7 };
+        return level;
+    }
+
+    struct level_compression : nabu::default_compression {
+        static nabu::array_view<std::byte> dictionary() {
+            static auto const dictionary = nabu::make_compression_dictionary(make_level(64));
+            return dictionary;
+        }
+    };
+}
+
+TEST_CASE("lz compression", "[compression]") {
+    using namespace nabu;
+    auto src = std::vector<std::byte>(10000);
+    for (size_t i = 0; i < src.size(); ++i) src[i] = static_cast<std::byte>(i % 13);
+
+    auto compressed = std::vector<std::byte>(lz::max_compressed_size(src.size()));
+    int const size = lz::compress(src, compressed.data());
+    REQUIRE(size < static_cast<int>(src.size()) / 10);
+
+    auto decompressed = std::vector<std::byte>(src.size());
+    REQUIRE(lz::decompress({ compressed.data(), static_cast<size_t>(size) },
+                           decompressed.data(), decompressed.size()));
+    REQUIRE(decompressed == src);
+
+    // Wrong sizes and truncated data are rejected.
+    REQUIRE(!lz::decompress({ compressed.data(), static_cast<size_t>(size) },
+                            decompressed.data(), decompressed.size() - 1));
+    REQUIRE(!lz::decompress({ compressed.data(), static_cast<size_t>(size - 1) },
+                            decompressed.data(), decompressed.size()));
+}
+
+TEST_CASE("lz compression with a dictionary", "[compression]") {
+    using namespace nabu;
+    auto const dictionary = make_compression_dictionary(std::string{ "the quick brown fox jumps over the lazy dog" });
+    auto const text = std::string{ "the lazy dog jumps over the quick brown fox" };
+    auto const src = array_view<std::byte>{ reinterpret_cast<std::byte const*>(text.data()), text.size() };
+
+    auto compressed = std::vector<std::byte>(lz::max_compressed_size(text.size()));
+    int const plain_size  = lz::compress(src, compressed.data());
+    int const primed_size = lz::compress(src, compressed.data(), dictionary);
+    REQUIRE(primed_size < plain_size);
+
+    auto decompressed = std::string(text.size(), ' ');
+    REQUIRE(lz::decompress({ compressed.data(), static_cast<size_t>(primed_size) },
+                           reinterpret_cast<std::byte*>(decompressed.data()), text.size(), dictionary));
+    REQUIRE(decompressed == text);
+}
+
+TEST_CASE("serialization of compressed", "[compression]") {
+    using namespace nabu;
+
+    SECTION("below the threshold, the payload is not compressed") {
+        auto const level = compressed<level_t>{ make_level(4) };
+        int const raw_size = serialized_size(level.get());
+        REQUIRE(serialized_size(level) == serialized_count_size(raw_size << 1, count_encoding::varint{}) + raw_size);
+
+        auto buffer = std::vector<std::byte>(serialized_size(level));
+        auto stream = throw_stream{ buffer };
+        stream << level;
+        REQUIRE(stream.is_empty());
+
+        auto copy = compressed<level_t>{};
+        stream = throw_stream{ buffer };
+        stream >> copy;
+        REQUIRE(copy == level);
+    }
+    SECTION("above the threshold, the payload is compressed") {
+        auto const level = compressed<level_t, level_compression>{ make_level(1000) };
+        int const size = serialized_size(level);
+        REQUIRE(size < serialized_size(level.get()) / 10);
+
+        auto buffer = std::vector<std::byte>(size);
+        auto stream = throw_stream{ buffer };
+        stream << level;
+        REQUIRE(stream.is_empty());
+
+        auto copy = compressed<level_t, level_compression>{};
+        stream = throw_stream{ buffer };
+        stream >> copy;
+        REQUIRE(copy == level);
+
+        auto truncated = checked_stream{ buffer.data(), size - 1 };
+        truncated >> copy;
+        REQUIRE(truncated.error);
+        REQUIRE(truncated.begin == buffer.data());
+    }
+}
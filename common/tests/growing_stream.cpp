@@ -0,0 +1,57 @@
+
+#include <catch.hpp>
+#include <growing_stream.hpp>
+#include <numeric>
+
+
+namespace {
+    using resource_t = nabu::block_allocator_resource<64>;
+
+    std::vector<std::byte> concatenate(std::vector<nabu::buffer_span> const& segments) {
+        auto bytes = std::vector<std::byte>{};
+        for (auto const& segment : segments) {
+            bytes.insert(bytes.end(), segment.begin, segment.end);
+        }
+        return bytes;
+    }
+}
+
+TEST_CASE("growing stream serialization", "[growing_stream]") {
+    using namespace nabu;
+    auto resource = resource_t{ 2 };
+    auto stream = growing_stream{ resource };
+
+    auto const small = std::string(40, 's');
+    auto large = std::vector<int>(100);
+    std::iota(large.begin(), large.end(), 0);
+
+    stream << 42 << small << small << large << 'c';
+    REQUIRE(stream.size() == serialized_size(42) + 2 * serialized_size(small)
+                           + serialized_size(large) + serialized_size('c'));
+
+    // The large vector has it's own allocation, and 'c' follows the second string.
+    auto const& segments = stream.segments();
+    REQUIRE(segments.size() == 4);
+    REQUIRE(segments[2].size() == serialized_size(large));
+    REQUIRE(segments[3].begin == segments[1].end);
+
+    auto bytes = concatenate(stream.segments());
+    REQUIRE(static_cast<int>(bytes.size()) == stream.size());
+
+    int i;
+    std::string s1, s2;
+    std::vector<int> v;
+    char c;
+    auto span = throw_stream{ bytes };
+    span >> i >> s1 >> s2 >> v >> c;
+    REQUIRE(span.is_empty());
+    REQUIRE(i == 42);
+    REQUIRE(s1 == small);
+    REQUIRE(s2 == small);
+    REQUIRE(v == large);
+    REQUIRE(c == 'c');
+
+    stream.clear();
+    REQUIRE(stream.size() == 0);
+    REQUIRE(stream.segments().empty());
+}
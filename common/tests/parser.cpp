@@ -1,6 +1,8 @@
 
 #include <catch.hpp>
 #include <msg/parser.hpp>
+#include <msg/static_parser.hpp>
+#include <algorithm>
 
 
 namespace {
@@ -36,3 +38,183 @@ TEST_CASE("test message", "[parser]") {
     received.deserialize(span);
     REQUIRE(triggered);
 }
+
+namespace {
+    struct message_view_t {
+        static constexpr nabu::id_type id = 12;
+
+        int num;
+        std::string_view name;
+    };
+}
+
+TEST_CASE("test borrowed message", "[parser]") {
+    std::byte buffer[100];
+    auto span = nabu::throw_stream{ buffer };
+
+    auto sender = nabu::msg::parser{};
+    sender.serialize(span, message_t{ 42, "hello" });
+
+    auto received = nabu::msg::parser{};
+    bool triggered = false;
+    received.set_callback([&] (message_view_t const& m) {
+        triggered = true;
+        REQUIRE(m.num == 42);
+        REQUIRE(m.name == "hello");
+        REQUIRE(reinterpret_cast<std::byte const*>(m.name.data()) > buffer);
+        REQUIRE(reinterpret_cast<std::byte const*>(m.name.data()) < buffer + sizeof(buffer));
+    });
+
+    span.begin = buffer;
+    received.deserialize(span);
+    REQUIRE(triggered);
+}
+
+namespace {
+    struct other_message_t {
+        static constexpr nabu::id_type id = 13;
+
+        std::vector<int> values;
+    };
+}
+
+TEST_CASE("test token framing", "[parser]") {
+    using namespace nabu;
+    std::byte buffer[100];
+    auto span = throw_stream{ buffer };
+
+    auto const msg = message_t{ 42, "hello" };
+
+    auto sender = msg::parser{ msg::framing::tokens };
+    sender.serialize(span, msg);
+    REQUIRE(static_cast<char>(buffer[0]) == '{');
+    REQUIRE(static_cast<char>(span.begin[-1]) == '}');
+    int const size = span.begin - buffer;
+
+    auto received = msg::parser{ msg::framing::tokens };
+    bool triggered = false;
+    received.set_callback([&] (message_t&& m) {
+        triggered = true;
+        REQUIRE(m == msg);
+    });
+
+    REQUIRE(received.frame_size(buffer_span{ buffer, buffer + size - 1 }) == invalid_serialized_size);
+    REQUIRE(received.frame_size(buffer_span{ buffer, buffer + sizeof(buffer) }) == size);
+
+    span.begin = buffer;
+    received.deserialize(span);
+    REQUIRE(triggered);
+    REQUIRE(span.begin == buffer + size);
+}
+
+TEST_CASE("test length prefixed framing", "[parser]") {
+    using namespace nabu;
+    static_assert(msg::frame_header_size == sizeof(id_type) + sizeof(uint32_t));
+    std::byte buffer[100];
+    auto span = throw_stream{ buffer };
+
+    auto const msg = message_t{ 42, "hello" };
+
+    auto sender = msg::parser{};
+    sender.serialize(span, other_message_t{ { 1, 2, 3 } });
+    sender.serialize(span, msg);
+    int const first_size = msg::frame_header_size + serialized_size(other_message_t{ { 1, 2, 3 } });
+    int const size = span.begin - buffer;
+    REQUIRE(size == first_size + msg::frame_header_size + serialized_size(msg));
+
+    auto received = msg::parser{};
+    bool triggered = false;
+    received.set_callback([&] (message_t const& m) {
+        triggered = true;
+        REQUIRE(m == msg);
+    });
+
+    // Frames are complete once their payload is received.
+    REQUIRE(received.frame_size(buffer_span{ buffer, buffer + 3 }) == invalid_serialized_size);
+    REQUIRE(received.frame_size(buffer_span{ buffer, buffer + first_size - 1 }) == invalid_serialized_size);
+    REQUIRE(received.frame_size(buffer_span{ buffer, buffer + size }) == first_size);
+
+    // The message without callback is skipped.
+    span = throw_stream{ buffer, buffer + size };
+    received.deserialize(span);
+    REQUIRE(!triggered);
+    REQUIRE(span.begin == buffer + first_size);
+    received.deserialize(span);
+    REQUIRE(triggered);
+    REQUIRE(span.is_empty());
+
+    span = throw_stream{ buffer + first_size, buffer + size - 1 };
+    REQUIRE_THROWS_AS(received.deserialize(span), msg::parser_error);
+}
+
+TEST_CASE("test framing in growing stream", "[parser]") {
+    using namespace nabu;
+    auto resource = growing_stream_resource_type{ 4 };
+    auto stream = growing_stream{ resource };
+
+    auto const msg = other_message_t{ std::vector<int>(300, 7) };
+    auto sender = msg::parser{};
+    sender.serialize(stream, message_t{ 42, "hello" });
+    sender.serialize(stream, msg);
+
+    auto buffer = std::vector<std::byte>{};
+    for (auto const& segment : stream.segments()) buffer.insert(buffer.end(), segment.begin, segment.end);
+
+    auto received = msg::parser{};
+    int count = 0;
+    received.set_callback([&] (message_t&&) { ++count; });
+    received.set_callback([&] (other_message_t const& m) {
+        ++count;
+        REQUIRE(m.values == msg.values);
+    });
+
+    auto span = throw_stream{ buffer };
+    while (!span.is_empty()) received.deserialize(span);
+    REQUIRE(count == 2);
+}
+
+TEST_CASE("test static parser", "[parser]") {
+    using namespace nabu;
+    std::byte buffer[100];
+
+    for (auto const mode : { msg::framing::length_prefixed, msg::framing::tokens }) {
+        auto span = throw_stream{ buffer };
+        auto const msg = message_t{ 42, "hello" };
+
+        // Both parsers write the same frames.
+        auto sender = msg::static_parser<message_t, other_message_t>{ mode };
+        sender.serialize(span, other_message_t{ { 1, 2, 3 } });
+        sender.serialize(span, msg);
+        auto runtime_span = throw_stream{ span.begin, buffer + sizeof(buffer) };
+        msg::parser{ mode }.serialize(runtime_span, msg);
+        int const size = span.begin - buffer;
+        int const msg_size = runtime_span.begin - span.begin;
+        REQUIRE(std::equal(span.begin, runtime_span.begin, span.begin - msg_size));
+
+        auto received = msg::static_parser<message_t, other_message_t>{ mode };
+        int count = 0;
+        auto const handler = overloaded{
+            [&] (message_t& m) { ++count; REQUIRE(m == msg); },
+            [&] (other_message_t const& m) { ++count; REQUIRE(m.values == std::vector<int>{ 1, 2, 3 }); }
+        };
+
+        span = throw_stream{ buffer, buffer + size };
+        REQUIRE(received.frame_size(span) == size - msg_size);
+        received.deserialize(span, handler);
+        received.deserialize(span, handler);
+        REQUIRE(count == 2);
+        REQUIRE(span.is_empty());
+    }
+
+    // Ids which are not in the list are skipped.
+    auto span = throw_stream{ buffer };
+    msg::parser{}.serialize(span, other_message_t{ { 1 } });
+    auto const end = span.begin;
+
+    auto received = msg::static_parser<message_t>{};
+    bool triggered = false;
+    span.begin = buffer;
+    received.deserialize(span, [&] (message_t&) { triggered = true; });
+    REQUIRE(!triggered);
+    REQUIRE(span.begin == end);
+}
@@ -0,0 +1,86 @@
+#include <catch.hpp>
+#include <net/receive_buffer.hpp>
+#include <msg/parser.hpp>
+
+
+namespace {
+    struct chat_t {
+        static constexpr nabu::id_type id = 3;
+
+        std::string text;
+    };
+
+    // Copies 'bytes' in the buffer by pieces of at most 'piece' bytes, and parses
+    // the complete frames after each piece.
+    int receive_by_pieces(nabu::net::receive_buffer& buffer, nabu::msg::parser& parser,
+                          std::vector<std::byte> const& bytes, size_t const piece) {
+        using namespace nabu;
+        int frames = 0;
+        size_t sent = 0;
+        while (sent < bytes.size()) {
+            auto const free = buffer.prepare();
+            auto const size = std::min({ piece, bytes.size() - sent, static_cast<size_t>(free.size()) });
+            memcpy(free.begin, bytes.data() + sent, size);
+            buffer.commit(size);
+            sent += size;
+
+            auto const data = buffer.data();
+            auto span = data;
+            int frame_size;
+            while ((frame_size = parser.frame_size(span)) != invalid_serialized_size) {
+                auto frame = throw_stream{ span.begin, frame_size };
+                span.begin += frame_size;
+                parser.deserialize(frame);
+                ++frames;
+            }
+            buffer.consume(span.begin - data.begin);
+        }
+        return frames;
+    }
+}
+
+TEST_CASE("receive buffer reassembly", "[receive_buffer]") {
+    using namespace nabu;
+    auto const messages = std::vector<chat_t>{ { "hello" }, { std::string(3000, 'a') }, { "" }, { "bye" } };
+
+    auto resource = growing_stream_resource_type{ 4 };
+    auto stream = growing_stream{ resource };
+    auto sender = msg::parser{};
+    for (auto const& message : messages) sender.serialize(stream, message);
+
+    auto bytes = std::vector<std::byte>{};
+    for (auto const& segment : stream.segments()) bytes.insert(bytes.end(), segment.begin, segment.end);
+
+    for (size_t const piece : { 1, 7, 100, 5000 }) {
+        auto buffer = net::receive_buffer{ 64 };
+        auto received = std::vector<std::string>{};
+        auto parser = msg::parser{};
+        parser.set_callback([&] (chat_t const& chat) { received.push_back(chat.text); });
+
+        REQUIRE(receive_by_pieces(buffer, parser, bytes, piece) == 4);
+        REQUIRE(buffer.size() == 0);
+        REQUIRE(buffer.capacity() >= 3000);
+        for (size_t i = 0; i < messages.size(); ++i) REQUIRE(received[i] == messages[i].text);
+    }
+}
+
+TEST_CASE("receive buffer maximum size", "[receive_buffer]") {
+    using namespace nabu;
+    auto buffer = net::receive_buffer{ 16, 32 };
+    REQUIRE(buffer.prepare().size() == 16);
+    buffer.commit(16);
+
+    // Unread bytes are moved to the front before growing.
+    buffer.consume(10);
+    REQUIRE(buffer.prepare().size() == 10);
+    REQUIRE(buffer.data().size() == 6);
+    buffer.commit(10);
+
+    REQUIRE(buffer.prepare().size() == 16);
+    buffer.commit(16);
+    REQUIRE(buffer.capacity() == 32);
+    REQUIRE(buffer.prepare().is_empty());
+
+    buffer.clear();
+    REQUIRE(buffer.prepare().size() == 32);
+}
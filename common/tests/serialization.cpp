@@ -1,8 +1,11 @@
 
 #include <catch.hpp>
 #include <serialization.hpp>
+#include <array>
 #include <list>
 #include <map>
+#include <set>
+#include <unordered_map>
 
 
 namespace {
@@ -60,15 +63,113 @@ TEST_CASE("serialization of custom type", "[serialization]") {
 
 TEST_CASE("serialization of std::string", "[serialization]") {
     char const messsage[] = "hello serialization !";
-    int const size = sizeof(nabu::serialized_count_t) + sizeof(messsage) - 1;
+    int const size = 1 + sizeof(messsage) - 1;
     basic_test(std::string{ messsage }, size, nabu::serial_tag::array{});
 }
 
+namespace nabu {
+    template <>
+    struct serial_traits<std::vector<short>> {
+        using count_type = count_encoding::fixed<uint16_t>;
+    };
+}
+
+TEST_CASE("serialization of counts", "[serialization]") {
+    using namespace nabu;
+    using varint = count_encoding::varint;
+
+    REQUIRE(serialized_count_size(0,       varint{}) == 1);
+    REQUIRE(serialized_count_size(127,     varint{}) == 1);
+    REQUIRE(serialized_count_size(128,     varint{}) == 2);
+    REQUIRE(serialized_count_size(16383,   varint{}) == 2);
+    REQUIRE(serialized_count_size(16384,   varint{}) == 3);
+    REQUIRE(serialized_count_size(1 << 20, varint{}) == 3);
+
+    std::byte buffer[5];
+    for (size_t const count : { 0u, 1u, 127u, 128u, 300u, 70000u, 0xFFFFFFFFu }) {
+        auto span = buffer_span{ buffer, buffer + sizeof(buffer) };
+        serialize_count(span, count, varint{});
+        int const size = span.begin - buffer;
+        REQUIRE(size == serialized_count_size(count, varint{}));
+
+        span.begin = buffer;
+        size_t read;
+        REQUIRE(serialized_count_size(buffer_span{ buffer, buffer + size }, read, varint{}) == size);
+        REQUIRE(read == count);
+        REQUIRE(serialized_count_size(buffer_span{ buffer, buffer + size - 1 }, read, varint{})
+            == invalid_serialized_size);
+        REQUIRE(deserialize_count(span, varint{}) == count);
+        REQUIRE(span.begin == buffer + size);
+    }
+}
+
+TEST_CASE("serialization of large collections", "[serialization]") {
+    auto const big = std::vector<char>(70000, 'x');
+    basic_test(big, 3 + 70000, nabu::serial_tag::array{});
+}
+
+TEST_CASE("serialization of fixed count", "[serialization]") {
+    auto const values = std::vector<short>{ 1, 2, 3 };
+    basic_test(values, sizeof(uint16_t) + 3 * sizeof(short), nabu::serial_tag::array{});
+}
+
+TEST_CASE("serialization byte order", "[serialization]") {
+    using namespace nabu;
+    auto const to_bytes = [] (auto const& val) {
+        auto buffer = std::vector<std::byte>(serialized_size(val));
+        auto stream = throw_stream{ buffer };
+        stream << val;
+        return buffer;
+    };
+    auto const bytes = [] (std::initializer_list<int> values) {
+        auto buffer = std::vector<std::byte>{};
+        for (int v : values) buffer.push_back(static_cast<std::byte>(v));
+        return buffer;
+    };
+
+    // The wire format is little-endian whatever the host.
+    REQUIRE(to_bytes(uint32_t{ 0x01020304 }) == bytes({ 4, 3, 2, 1 }));
+    REQUIRE(to_bytes(std::vector<uint16_t>{ 0x0102, 0x0304 }) == bytes({ 2, 2, 1, 4, 3 }));
+    REQUIRE(to_bytes(std::vector<short>{ 0x0102 }) == bytes({ 1, 0, 2, 1 }));
+
+    uint64_t values[] = { 0x0102030405060708, 0x1112131415161718 };
+    byte_swap_array<8>(reinterpret_cast<std::byte*>(values), 2);
+    REQUIRE(values[0] == 0x0807060504030201);
+    REQUIRE(values[1] == 0x1817161514131211);
+    REQUIRE(byte_swap(uint16_t{ 0x0102 }) == 0x0201);
+}
+
 TEST_CASE("serialization of std::list", "[serialization]") {
-    int const size = sizeof(nabu::serialized_count_t) + sizeof(int) * 5;
+    int const size = 1 + sizeof(int) * 5;
     basic_test(std::list{ 1, 2, 3, 4, 5 }, size, nabu::serial_tag::iterable{});
 }
 
+TEST_CASE("serialization of std::vector<bool>", "[serialization]") {
+    // Its elements are proxies : they are deserialized by value, then emplaced.
+    basic_test(std::vector<bool>{ true, false, false, true }, 1 + 4 * sizeof(bool), nabu::serial_tag::iterable{});
+
+    auto const values = std::vector<bool>{ true, true };
+    auto buffer = std::vector<std::byte>(nabu::serialized_size(values));
+    auto stream = nabu::throw_stream{ buffer };
+    stream << values;
+    auto copy = std::vector<bool>{ false, false, false };
+    stream = nabu::throw_stream{ buffer };
+    REQUIRE(nabu::try_deserialize(stream, copy));
+    REQUIRE(copy == values);
+}
+
+TEST_CASE("serialization of associative containers", "[serialization]") {
+    basic_test(std::set{ 5, 1, 4, 2, 3 }, 1 + sizeof(int) * 5, nabu::serial_tag::iterable{});
+
+    // Equivalent keys keep their order.
+    auto const multimap = std::multimap<int, int>{ { 2, 1 }, { 1, 2 }, { 2, 3 }, { 2, 4 } };
+    basic_test(multimap, 1 + sizeof(int) * 8, nabu::serial_tag::iterable{});
+
+    auto unordered = std::unordered_map<int, int>{};
+    for (int i = 0; i < 100; ++i) unordered.emplace(i * 7, i);
+    basic_test(unordered, 1 + sizeof(int) * 200, nabu::serial_tag::iterable{});
+}
+
 namespace {
     struct person_t {
         int age;
@@ -100,14 +201,58 @@ TEST_CASE("serialization of aggregate", "[serialization]") {
         }
     };
     int const size = sizeof(int) + 
-        (sizeof("Robert") + sizeof("Patrick") + sizeof("Leon")
-            + 3 * (sizeof(nabu::serialized_count_t) - 1)) +
-        sizeof(nabu::serialized_count_t)
-            + 2 * (sizeof(int) + sizeof(float));
+        (sizeof("Robert") + sizeof("Patrick") + sizeof("Leon")) +
+        1 + 2 * (sizeof(int) + sizeof(float));
 
     basic_test(agg, size, nabu::serial_tag::aggregate{});
 }
 
+TEST_CASE("deserialization of truncated aggregate", "[serialization]") {
+    using namespace nabu;
+    auto const agg = aggregate_t{ 42, "Robert", { { "Patrick", { 67, 1.76f } } } };
+
+    auto buffer = std::vector<std::byte>(serialized_size(agg));
+    auto stream = throw_stream{ buffer };
+    stream << agg;
+
+    for (auto size = 0u; size < buffer.size(); ++size) {
+        auto span = checked_stream{ buffer.data(), static_cast<int>(size) };
+        aggregate_t copy{};
+        span >> copy;
+        REQUIRE(span.error);
+        REQUIRE(span.begin == buffer.data());
+    }
+}
+
+TEST_CASE("benchmark deserialization of aggregate", "[.][benchmark]") {
+    using namespace nabu;
+    auto agg = aggregate_t{ 42, "Robert", {} };
+    for (int i = 0; i < 100; ++i) {
+        agg.relatives.emplace(fmt::format("relative {}", i), person_t{ i, 1.5f });
+    }
+    auto buffer = std::vector<std::byte>(serialized_size(agg));
+    auto stream = throw_stream{ buffer };
+    stream << agg;
+
+    constexpr int iterations = 1000;
+    aggregate_t copy{};
+
+    BENCHMARK("size then deserialize") {
+        for (int i = 0; i < iterations; ++i) {
+            auto span = buffer_span{ buffer.data(), buffer.data() + buffer.size() };
+            if (serialized_size(span, type_tag<aggregate_t>{}) != invalid_serialized_size)
+                deserialize(span, copy);
+        }
+    }
+    BENCHMARK("single pass try_deserialize") {
+        for (int i = 0; i < iterations; ++i) {
+            auto span = buffer_span{ buffer.data(), buffer.data() + buffer.size() };
+            try_deserialize(span, copy);
+        }
+    }
+    REQUIRE(copy == agg);
+}
+
 TEST_CASE("serialization failures", "[serialization]") {
     using namespace nabu;
     std::byte buffer[3];
@@ -126,13 +271,311 @@ TEST_CASE("serialization failures", "[serialization]") {
 
     using tested_type = std::list<char>;
     span.error = false;
-    span << serialized_count_t{ 2 };
+    serialize_count(span, 3, count_encoding::varint{});
+    span.begin = buffer;
 
     auto const size = serialized_size(span, type_tag<tested_type>{});
     REQUIRE(size == invalid_serialized_size);
 }
 
+namespace {
+    struct fixed_aggregate_t {
+        int id;
+        std::pair<short, char> pair;
+        std::tuple<float, double> tuple;
+    };
+
+    bool operator==(fixed_aggregate_t const& lhs, fixed_aggregate_t const& rhs) {
+        return lhs.id == rhs.id && lhs.pair == rhs.pair && lhs.tuple == rhs.tuple;
+    }
+}
+
+TEST_CASE("static serialized size", "[serialization]") {
+    using namespace nabu;
+    constexpr int fixed_size = sizeof(int) + sizeof(short) + sizeof(char) + sizeof(float) + sizeof(double);
+
+    static_assert(static_serialized_size<int> == sizeof(int));
+    static_assert(static_serialized_size<fixed_aggregate_t> == fixed_size);
+    static_assert(static_serialized_size<person_t> == sizeof(person_t));
+    static_assert(!has_static_serialized_size<std::string>);
+    static_assert(!has_static_serialized_size<aggregate_t>);
+    static_assert(!has_static_serialized_size<std::tuple<int, std::string>>);
+
+    basic_test(fixed_aggregate_t{ 1, { 2, 'c' }, { 3.f, 4. } }, fixed_size, serial_tag::aggregate{});
+    basic_test(std::list<fixed_aggregate_t>(3), 1 + 3 * fixed_size, serial_tag::iterable{});
+}
+
+namespace {
+    struct padded_t {
+        char c;
+        int i;
+        short s;
+    };
+    struct nested_padded_t {
+        padded_t padded;
+        double d;
+    };
+    struct padded_array_t {
+        std::array<padded_t, 2> items;
+        char c;
+    };
+    // att can't split these into their members : they are copied as a whole.
+    struct named_t {
+        char name[4];
+        int id;
+    };
+    struct derived_t : named_t {
+        int level;
+    };
+
+    bool operator==(padded_t const& lhs, padded_t const& rhs) {
+        return lhs.c == rhs.c && lhs.i == rhs.i && lhs.s == rhs.s;
+    }
+    bool operator==(nested_padded_t const& lhs, nested_padded_t const& rhs) {
+        return lhs.padded == rhs.padded && lhs.d == rhs.d;
+    }
+    bool operator==(padded_array_t const& lhs, padded_array_t const& rhs) {
+        return lhs.items == rhs.items && lhs.c == rhs.c;
+    }
+    bool operator==(named_t const& lhs, named_t const& rhs) {
+        return memcmp(lhs.name, rhs.name, sizeof(lhs.name)) == 0 && lhs.id == rhs.id;
+    }
+    bool operator==(derived_t const& lhs, derived_t const& rhs) {
+        return static_cast<named_t const&>(lhs) == rhs && lhs.level == rhs.level;
+    }
+}
+
+TEST_CASE("serialization of padded types", "[serialization]") {
+    using namespace nabu;
+    constexpr int packed_size = sizeof(char) + sizeof(int) + sizeof(short);
+
+    static_assert(!has_padding<int>);
+    static_assert(!has_padding<person_t>);
+    static_assert(has_padding<padded_t>);
+    static_assert(padding_of<padded_t> == sizeof(padded_t) - packed_size);
+    static_assert(static_serialized_size<padded_t> == packed_size);
+    static_assert(static_serialized_size<nested_padded_t> == packed_size + sizeof(double));
+    static_assert(static_serialized_size<padded_array_t> == 2 * packed_size + sizeof(char));
+
+    basic_test(padded_t{ 'a', 1, 2 }, packed_size, serial_tag::trivial{});
+    basic_test(nested_padded_t{ { 'a', 1, 2 }, 3. }, packed_size + sizeof(double), serial_tag::trivial{});
+    basic_test(std::vector<padded_t>{ { 'a', 1, 2 }, { 'b', 3, 4 } }, 1 + 2 * packed_size, serial_tag::array{});
+    basic_test(padded_array_t{ { { { 'a', 1, 2 }, { 'b', 3, 4 } } }, 'c' }, 2 * packed_size + 1, serial_tag::trivial{});
+
+    // Aggregates with an array member or a base class are copied as a whole.
+    static_assert(!has_padding<named_t>);
+    static_assert(!has_padding<derived_t>);
+    auto derived = derived_t{};
+    derived.id = 1;
+    derived.level = 2;
+    memcpy(derived.name, "orc", 4);
+    basic_test(named_t{ "elf", 1 }, sizeof(named_t), serial_tag::trivial{});
+    basic_test(derived, sizeof(derived_t), serial_tag::trivial{});
+}
+
+TEST_CASE("serialization of columnar vectors", "[serialization]") {
+    using namespace nabu;
+    auto const persons = columnar_vector<person_t>{ { 1, 1.5f }, { 2, 2.5f }, { 3, 3.5f } };
+    basic_test(persons, 1 + 3 * sizeof(person_t), serial_tag::custom{});
+
+    auto buffer = std::vector<std::byte>(serialized_size(persons));
+    auto stream = throw_stream{ buffer };
+    stream << persons;
+    for (int i = 0; i < 3; ++i) {
+        int age;
+        memcpy(&age, buffer.data() + 1 + i * sizeof(int), sizeof(int));
+        REQUIRE(age == i + 1);
+    }
+
+    auto const aggregates = columnar_vector<aggregate_t>{
+        { 1, "first", {} },
+        { 2, "second", { { "relative", { 30, 1.8f } } } }
+    };
+    int const size = serialized_size(aggregates);
+    basic_test(aggregates, size, serial_tag::custom{});
+
+    buffer.resize(size);
+    stream = throw_stream{ buffer };
+    stream << aggregates;
+
+    auto truncated = checked_stream{ buffer.data(), size - 1 };
+    auto copy = columnar_vector<aggregate_t>{};
+    truncated >> copy;
+    REQUIRE(truncated.error);
+    REQUIRE(truncated.begin == buffer.data());
+}
+
+TEST_CASE("serialization of interned strings", "[serialization]") {
+    using namespace nabu;
+    using names_t = std::vector<interned_string>;
+    auto const names = names_t{ "goblin", "orc", "goblin" };
+    int const full_size = 3 * 1 + 6 + 3 + 6;
+
+    SECTION("without a scope, strings are sent in full") {
+        basic_test(names, 1 + full_size, serial_tag::iterable{});
+    }
+    SECTION("strings are sent as handles once committed") {
+        auto sender = string_table{};
+        auto receiver = string_table{};
+        auto buffer = std::vector<std::byte>(1 + full_size);
+
+        for (int i = 0; i < 2; ++i) {
+            auto send_scope = interning_scope{ sender };
+            int const size = serialized_size(names);
+            REQUIRE(size == (i == 0 ? 1 + full_size : 1 + 3));
+            auto stream = throw_stream{ buffer };
+            stream << names;
+            send_scope.commit();
+
+            auto receive_scope = interning_scope{ receiver };
+            auto copy = names_t{};
+            stream = throw_stream{ buffer.data(), size };
+            stream >> copy;
+            receive_scope.commit();
+            REQUIRE(copy == names);
+        }
+        REQUIRE(sender.size() == 2);
+        REQUIRE(receiver.size() == 2);
+    }
+    SECTION("strings are not registered without commit") {
+        auto sender = string_table{};
+        {
+            auto scope = interning_scope{ sender };
+            REQUIRE(serialized_size(names) == 1 + full_size);
+            auto buffer = std::vector<std::byte>(1 + full_size);
+            auto stream = throw_stream{ buffer };
+            stream << names;
+        }
+        REQUIRE(sender.size() == 0);
+    }
+    SECTION("unknown handles are rejected") {
+        std::byte buffer[] = { std::byte{ 1 } };
+        auto stream = checked_stream{ buffer };
+        auto copy = interned_string{};
+        stream >> copy;
+        REQUIRE(stream.error);
+    }
+}
+
+TEST_CASE("serialization of views", "[serialization]") {
+    using namespace nabu;
+    auto const name    = std::string{ "borrowed" };
+    auto const numbers = std::vector<int>{ 1, 2, 3 };
+    auto const names   = std::vector<std::string>{ "a", "bc", "def" };
+
+    auto buffer = std::vector<std::byte>(
+        serialized_size(name) + serialized_size(numbers) + serialized_size(names));
+    auto stream = throw_stream{ buffer };
+    stream << name << numbers << names;
+    REQUIRE(stream.is_empty());
+
+    std::string_view name_view;
+    array_view<int> numbers_view;
+    iterable_view<std::string> names_view;
+    stream.begin = buffer.data();
+    stream >> name_view >> numbers_view >> names_view;
+    REQUIRE(stream.is_empty());
+
+    REQUIRE(name_view == name);
+    REQUIRE(reinterpret_cast<std::byte const*>(name_view.data()) == buffer.data() + 1);
+    REQUIRE(std::vector<int>(numbers_view.begin(), numbers_view.end()) == numbers);
+    REQUIRE(numbers_view[2] == 3);
+    REQUIRE(names_view.size() == names.size());
+    REQUIRE(std::vector<std::string>(names_view.begin(), names_view.end()) == names);
+
+    // Views are serialized like their owning counterpart.
+    auto copy = std::vector<std::byte>(buffer.size());
+    stream = throw_stream{ copy };
+    stream << name_view << numbers_view << names_view;
+    REQUIRE(stream.is_empty());
+    REQUIRE(copy == buffer);
+
+    auto truncated = checked_stream{ buffer.data(), static_cast<int>(buffer.size()) - 1 };
+    truncated >> name_view >> numbers_view >> names_view;
+    REQUIRE(truncated.error);
+}
+
+namespace {
+    struct named_view_t {
+        std::string_view name;
+        uint64_t id;
+    };
+}
+
+TEST_CASE("serialization of aggregates holding views", "[serialization]") {
+    using namespace nabu;
+    static_assert(std::is_trivially_copyable_v<named_view_t>);
+    static_assert(sizeof(named_view_t) == sizeof(std::string_view) + sizeof(uint64_t));
+    static_assert(std::is_same_v<serial_tag_of<named_view_t>, serial_tag::aggregate>);
+    static_assert(!has_static_serialized_size<named_view_t>);
+
+    auto const name = std::string{ "borrowed" };
+    auto const sent = named_view_t{ name, 42 };
+    auto buffer = std::vector<std::byte>(serialized_size(sent));
+    REQUIRE(buffer.size() == 1 + name.size() + sizeof(uint64_t));
+
+    auto stream = throw_stream{ buffer };
+    stream << sent;
+    REQUIRE(stream.is_empty());
+
+    stream.begin = buffer.data();
+    REQUIRE(serialized_size(stream, type_tag<named_view_t>{}) == static_cast<int>(buffer.size()));
+    auto received = named_view_t{};
+    stream >> received;
+    REQUIRE(stream.is_empty());
+    REQUIRE(received.name == name);
+    REQUIRE(received.id == 42);
+    REQUIRE(reinterpret_cast<std::byte const*>(received.name.data()) == buffer.data() + 1);
+}
+
+TEST_CASE("deserialization reuses storage", "[serialization]") {
+    using namespace nabu;
+    auto const names = std::vector<std::string>{ "a", "bc" };
+
+    auto buffer = std::vector<std::byte>(serialized_size(names));
+    auto stream = throw_stream{ buffer };
+    stream << names;
+
+    auto copy = std::vector<std::string>{
+        std::string(100, 'x'), std::string(100, 'y'), std::string(100, 'z') };
+    copy.reserve(10);
+    auto const data       = copy.data();
+    auto const first_data = copy[0].data();
+
+    stream.begin = buffer.data();
+    stream >> copy;
+    REQUIRE(copy == names);
+    REQUIRE(copy.data() == data);
+    REQUIRE(copy[0].data() == first_data);
+}
+
+TEST_CASE("serialization of std::variant", "[serialization]") {
+    using namespace nabu;
+    using variant_t = std::variant<int, std::string, person_t>;
+
+    basic_test(variant_t{ 42 }, 1 + sizeof(int), serial_tag::custom{});
+    basic_test(variant_t{ std::string{ "hello" } }, 1 + 1 + 5, serial_tag::custom{});
+    basic_test(variant_t{ person_t{ 30, 1.8f } }, 1 + sizeof(person_t), serial_tag::custom{});
+
+    static_assert(static_serialized_size<std::variant<int, float>> == 1 + sizeof(int));
+    static_assert(!has_static_serialized_size<std::variant<int, double>>);
+
+    std::byte buffer[] = { std::byte{ 3 }, std::byte{ 0 }, std::byte{ 0 }, std::byte{ 0 }, std::byte{ 0 } };
+    auto stream = checked_stream{ buffer };
+    REQUIRE(serialized_size(stream, type_tag<variant_t>{}) == invalid_serialized_size);
+    variant_t v;
+    stream >> v;
+    REQUIRE(stream.error);
+    REQUIRE(stream.begin == buffer);
+
+    auto span = buffer_span{ buffer, buffer + sizeof(buffer) };
+    REQUIRE_THROWS_AS(deserialize(span, v), read_buffer_overflow);
+}
+
 TEST_CASE("check serial tags", "[serialization]") {
     using namespace nabu;
     REQUIRE(std::is_same_v<serial_tag_of<int*>, serial_tag::invalid>);
+    REQUIRE(std::is_same_v<serial_tag_of<long double>, serial_tag::invalid>);
+    REQUIRE(std::is_same_v<serial_tag_of<named_t>, serial_tag::trivial>);
+    REQUIRE(std::is_same_v<serial_tag_of<derived_t>, serial_tag::trivial>);
 }
@@ -0,0 +1,96 @@
+
+#include <catch.hpp>
+#include <serialization_delta.hpp>
+#include <map>
+
+
+namespace {
+    struct position_t {
+        float x;
+        float y;
+    };
+    struct entity_t {
+        int id;
+        std::string name;
+        position_t position;
+        std::vector<int> inventory;
+        std::map<std::string, int> stats;
+    };
+
+    bool operator==(position_t const& lhs, position_t const& rhs) {
+        return lhs.x == rhs.x && lhs.y == rhs.y;
+    }
+    bool operator==(entity_t const& lhs, entity_t const& rhs) {
+        return lhs.id        == rhs.id        &&
+               lhs.name      == rhs.name      &&
+               lhs.position  == rhs.position  &&
+               lhs.inventory == rhs.inventory &&
+               lhs.stats     == rhs.stats;
+    }
+
+    template <class T>
+    int delta_test(T const& current, T const& baseline) {
+        using namespace nabu;
+        auto buffer = std::vector<std::byte>(serialized_size(current) + 16);
+        auto span = buffer_span{ buffer.data(), buffer.data() + buffer.size() };
+        serialize_delta(span, current, baseline);
+        int const size = span.begin - buffer.data();
+
+        auto received = baseline;
+        span = buffer_span{ buffer.data(), buffer.data() + size };
+        deserialize_delta(span, received);
+        REQUIRE(span.is_empty());
+        REQUIRE(received == current);
+
+        for (int truncated = 0; truncated < size; ++truncated) {
+            auto copy = baseline;
+            span = buffer_span{ buffer.data(), buffer.data() + truncated };
+            REQUIRE(!try_deserialize_delta(span, copy));
+            REQUIRE(span.begin == buffer.data());
+        }
+        return size;
+    }
+}
+
+TEST_CASE("delta serialization of aggregate", "[serialization_delta]") {
+    auto const baseline = entity_t{ 1, "goblin", { 1.f, 2.f }, { 1, 2, 3 }, { { "hp", 10 } } };
+
+    // Unchanged : only the mask.
+    REQUIRE(delta_test(baseline, baseline) == 1);
+
+    auto moved = baseline;
+    moved.position.y = 3.f;
+    REQUIRE(delta_test(moved, baseline) == 1 + 1 + sizeof(float));
+
+    auto hurt = baseline;
+    hurt.stats["hp"] = 5;
+    REQUIRE(delta_test(hurt, baseline) == 1 + 1 + nabu::serialized_size(hurt.stats));
+
+    auto looted = baseline;
+    looted.inventory.push_back(4);
+    looted.name = "rich goblin";
+    REQUIRE(delta_test(looted, baseline) == 1 + nabu::serialized_size(looted.name)
+                                              + nabu::serialized_size(looted.inventory));
+}
+
+TEST_CASE("delta serialization of trivial aggregate", "[serialization_delta]") {
+    static_assert(std::is_same_v<nabu::serial_tag_of<position_t>, nabu::serial_tag::trivial>);
+    static_assert(nabu::is_delta_serializable<position_t>);
+
+    auto const baseline = position_t{ 1.f, 2.f };
+    REQUIRE(delta_test(baseline, baseline) == 1);
+    REQUIRE(delta_test(position_t{ 1.f, 3.f }, baseline) == 1 + sizeof(float));
+    REQUIRE(delta_test(position_t{ 4.f, 3.f }, baseline) == 1 + 2 * sizeof(float));
+}
+
+TEST_CASE("delta serialization of sequence", "[serialization_delta]") {
+    auto const baseline = std::vector<std::string>(20, "a");
+
+    auto current = baseline;
+    current[3]  = "b";
+    current[17] = "cc";
+    REQUIRE(delta_test(current, baseline) == 1 + 3 + (1 + 1) + (1 + 2));
+
+    current.resize(21);
+    REQUIRE(delta_test(current, baseline) == nabu::serialized_size(current));
+}
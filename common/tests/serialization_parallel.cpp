@@ -0,0 +1,47 @@
+#include <catch.hpp>
+#include <serialization_parallel.hpp>
+#include <list>
+
+
+namespace {
+    template <class T>
+    void parallel_test(T const& value) {
+        using namespace nabu;
+        int const size = serialized_size(value);
+        REQUIRE(parallel_serialized_size(value) == size);
+
+        auto sequential = std::vector<std::byte>(size);
+        auto span = buffer_span{ sequential.data(), sequential.data() + size };
+        serialize(span, value);
+
+        auto parallel = std::vector<std::byte>(size);
+        span = buffer_span{ parallel.data(), parallel.data() + size };
+        REQUIRE(parallel_try_serialize(span, value));
+        REQUIRE(span.is_empty());
+        REQUIRE(parallel == sequential);
+
+        span = buffer_span{ parallel.data(), parallel.data() + size - 1 };
+        REQUIRE(!parallel_try_serialize(span, value));
+        REQUIRE(span.begin == parallel.data());
+    }
+}
+
+TEST_CASE("parallel serialization", "[serialization]") {
+    constexpr int count = 3 * nabu::parallel_serialization_threshold + 7;
+
+    SECTION("array") {
+        auto ints = std::vector<int>(count);
+        for (int i = 0; i < count; ++i) ints[i] = i;
+        parallel_test(ints);
+    }
+    SECTION("iterable") {
+        auto names = std::vector<std::string>(count);
+        for (int i = 0; i < count; ++i) names[i] = std::string(i % 200, 'a');
+        parallel_test(names);
+
+        parallel_test(std::list<std::string>(names.begin(), names.end()));
+    }
+    SECTION("below the threshold") {
+        parallel_test(std::vector<std::string>(10, "small"));
+    }
+}
@@ -0,0 +1,61 @@
+#include <catch.hpp>
+#include <serialization_stats.hpp>
+
+
+namespace {
+    struct position_t {
+        int x, y;
+    };
+
+    struct entity_t {
+        std::string name;
+        position_t position;
+        std::vector<int> items;
+    };
+}
+
+#if defined(NABU_SERIALIZATION_STATS)
+
+TEST_CASE("serialization stats", "[serialization_stats]") {
+    using namespace nabu;
+    serialization_stats.clear();
+
+    auto const entity = entity_t{ "orc", { 1, 2 }, { 3, 4, 5 } };
+    auto buffer = std::vector<std::byte>(2 * serialized_size(entity));
+    auto stream = instrumented_stream{ buffer };
+    stream << entity << entity;
+
+    auto const type = serialization_stats.type_stats(name_of<entity_t>());
+    REQUIRE(type.count == 2);
+    REQUIRE(type.bytes == 2 * serialized_size(entity));
+
+    auto const name = serialization_stats.field_stats(name_of<entity_t>(), 0);
+    REQUIRE(name.type == name_of<std::string>());
+    REQUIRE(name.bytes == 2 * serialized_size(entity.name));
+    REQUIRE(serialization_stats.field_stats(name_of<entity_t>(), 2).bytes == 2 * serialized_size(entity.items));
+
+    // Nested aggregates are recorded as types too.
+    REQUIRE(serialization_stats.type_stats(name_of<position_t>()).count == 2);
+    REQUIRE(serialization_stats.field_stats(name_of<position_t>(), 1).bytes == 2 * sizeof(int));
+
+    REQUIRE_THROWS_AS(stream << entity, write_buffer_overflow);
+    REQUIRE(serialization_stats.type_stats(name_of<entity_t>()).count == 2);
+
+    serialization_stats.clear();
+    REQUIRE(serialization_stats.type_stats(name_of<entity_t>()).count == 0);
+}
+
+#else
+
+TEST_CASE("serialization stats disabled", "[serialization_stats]") {
+    using namespace nabu;
+    static_assert(std::is_same_v<instrumented_stream, throw_stream>);
+
+    auto const entity = entity_t{ "orc", { 1, 2 }, { 3, 4, 5 } };
+    auto buffer = std::vector<std::byte>(serialized_size(entity));
+    auto stream = instrumented_stream{ buffer };
+    stream << entity;
+    REQUIRE(stream.is_empty());
+}
+
+#endif
@@ -0,0 +1,95 @@
+#include <catch.hpp>
+#include <net/socket.hpp>
+#include <SFML/Network/TcpListener.hpp>
+#include <chrono>
+#include <thread>
+
+
+namespace {
+    struct greeting_t {
+        static constexpr nabu::id_type id = 20;
+
+        nabu::interned_string name;
+    };
+
+    struct farewell_t {
+        static constexpr nabu::id_type id = 21;
+
+        nabu::interned_string name;
+    };
+
+    // Frames the messages as the peer of a connection does, with it's send table.
+    template <class...Messages>
+    std::vector<std::byte> peer_frames(nabu::string_table& strings, Messages const&...msgs) {
+        using namespace nabu;
+        auto parser = msg::parser{};
+        auto bytes = std::vector<std::byte>(256);
+        auto stream = throw_stream{ bytes };
+        auto const send = [&] (auto const& msg) {
+            auto interning = interning_scope{ strings };
+            parser.serialize(stream, msg);
+            interning.commit();
+        };
+        (..., send(msgs));
+        bytes.resize(stream.begin - bytes.data());
+        return bytes;
+    }
+
+    // Receives until 'done' returns true or the connection is lost, for at most one second.
+    template <class F>
+    void receive_until(nabu::net::socket& socket, F const& done) {
+        using namespace std::literals;
+        auto const deadline = std::chrono::steady_clock::now() + 1s;
+        while (socket.is_connected() && !done() && std::chrono::steady_clock::now() < deadline) {
+            socket.receive_all();
+            std::this_thread::sleep_for(1ms);
+        }
+    }
+}
+
+TEST_CASE("socket interned strings", "[socket]") {
+    using namespace nabu;
+    sf::TcpListener listener;
+    REQUIRE(listener.listen(sf::Socket::AnyPort, sf::IpAddress::LocalHost) == sf::Socket::Done);
+
+    net::socket socket;
+    REQUIRE(socket.try_connect(sf::IpAddress::LocalHost, listener.getLocalPort(), sf::seconds(1)));
+    sf::TcpSocket peer;
+    REQUIRE(listener.accept(peer) == sf::Socket::Done);
+
+    auto names = std::vector<std::string>{};
+    socket.add_callback([&] (greeting_t&& msg) { names.push_back(msg.name); });
+    auto peer_strings = string_table{};
+
+    SECTION("strings are received as handles once received in full") {
+        auto const bytes = peer_frames(peer_strings, greeting_t{ "goblin" }, greeting_t{ "goblin" });
+        REQUIRE(peer.send(bytes.data(), bytes.size()) == sf::Socket::Done);
+
+        receive_until(socket, [&] { return names.size() == 2; });
+        REQUIRE(socket.is_connected());
+        REQUIRE(names == std::vector<std::string>{ "goblin", "goblin" });
+    }
+    SECTION("a message without callback resets the connection") {
+        // The skipped message registers "goblin" for the peer, which then sends it's handle.
+        auto const bytes = peer_frames(peer_strings, farewell_t{ "goblin" }, greeting_t{ "goblin" });
+        REQUIRE(bytes.size() == 2 * msg::frame_header_size + (1 + 6) + 1);
+        REQUIRE(peer.send(bytes.data(), bytes.size()) == sf::Socket::Done);
+
+        receive_until(socket, [&] { return !names.empty(); });
+        REQUIRE(!socket.is_connected());
+        REQUIRE(names.empty());
+    }
+    SECTION("a message failing to deserialize resets the connection") {
+        // The name is the handle 1, which was never sent in full.
+        auto bytes = std::vector<std::byte>(msg::frame_header_size + 1);
+        auto stream = throw_stream{ bytes };
+        stream << msg::frame_header{ greeting_t::id, 1 } << std::byte{ 1 << 1 | 1 };
+        auto const valid = peer_frames(peer_strings, greeting_t{ "goblin" });
+        bytes.insert(bytes.end(), valid.begin(), valid.end());
+        REQUIRE(peer.send(bytes.data(), bytes.size()) == sf::Socket::Done);
+
+        receive_until(socket, [&] { return !names.empty(); });
+        REQUIRE(!socket.is_connected());
+        REQUIRE(names.empty());
+    }
+}
@@ -2,30 +2,64 @@
 #pragma once
 
 #include <msg/parser.hpp>
+#include <net/socket.hpp>
 #include <logger.hpp>
 #include <function2.hpp>
 #include <SFML/Network.hpp>
+#include <chrono>
 #include <memory>
 
+// The epoll backend waits for the readiness of the listener and of the connections, and only
+// updates the ready ones. Other platforms poll every connection in each update.
+
+#if defined(__linux__)
+    #define NABU_SERVER_EPOLL
+#endif
+
 
 namespace nabu::net {
 
+namespace detail {
+    // Exposes the OS handle, for the readiness notifications.
+    class tcp_listener : public sf::TcpListener {
+    public:
+        using sf::TcpListener::getHandle;
+    };
+}
+
 class server {
 public:
 	explicit server(uint16_t const port);
+	~server();
+
+	server(server&&) = delete;
+
+	// Waits until a connection or data arrives, or until 'timeout' expires.
+	// Without the epoll backend, it sleeps for 'timeout'.
+	void wait(std::chrono::milliseconds timeout);
+
     void update();
 
 	fu2::unique_function<void()> on_welcome;
 	fu2::unique_function<void()> on_message;
 private:
-	sf::TcpListener listener_;
-	std::unique_ptr<sf::TcpSocket> next_socket_;
-	std::vector<std::unique_ptr<sf::TcpSocket>> sockets_;
+	detail::tcp_listener listener_;
+	std::unique_ptr<detail::tcp_socket> next_socket_;
+	std::vector<std::unique_ptr<detail::tcp_socket>> sockets_;
 	msg::parser parser_;
 	std::vector<std::byte> buffer_;
+#if defined(NABU_SERVER_EPOLL)
+	int epoll_;
+	bool listener_ready_;
+	std::vector<detail::tcp_socket*> ready_sockets_;
+#endif
 
 	void update_new_connection();
 	void update_connections();
+
+	// Receives from 'socket', and returns false if it has been disconnected.
+	bool update_connection(detail::tcp_socket& socket);
+	void remove_connection(detail::tcp_socket& socket);
 };
 
 } // nabu::net
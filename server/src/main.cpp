@@ -2,6 +2,7 @@
 #include <net/server.hpp>
 #include <terminal.hpp>
 #include <database.hpp>
+#include <serialization_stats.hpp>
 #include <future>
 #include "reflection.hpp"
 
@@ -19,12 +20,17 @@ int main() {
         terminal.commands["quit"] = [&] (auto&) {
             quit = true;
         };
+#if defined(NABU_SERIALIZATION_STATS)
+        terminal.commands["serialization_stats"] = [] (auto&) {
+            logger.info("{}", serialization_stats.report());
+        };
+#endif
 
         while (!quit) {
             using namespace std::literals;
             server.update();
             terminal.update();
-            std::this_thread::sleep_for(20ms);
+            server.wait(20ms);
         }
     }
     catch (std::exception const& e) {
@@ -1,15 +1,37 @@
-
 #include <net/server.hpp>
+#include <algorithm>
+#include <thread>
+#include <utility>
+
+#if defined(NABU_SERVER_EPOLL)
+	#include <sys/epoll.h>
+	#include <unistd.h>
+	#include <cerrno>
+	#include <cstring>
+#endif
 
 
 namespace nabu::net {
 
 namespace {
-	std::unique_ptr<sf::TcpSocket> make_socket() {
-		auto ptr = std::make_unique<sf::TcpSocket>();
+	std::unique_ptr<detail::tcp_socket> make_socket() {
+		auto ptr = std::make_unique<detail::tcp_socket>();
 		ptr->setBlocking(false);
 		return ptr;
 	}
+
+#if defined(NABU_SERVER_EPOLL)
+	constexpr int max_events = 256;
+
+	// Level-triggered : a connection having unread data stays ready.
+	void watch(int const epoll, sf::SocketHandle const handle, void* const data) {
+		auto event = epoll_event{};
+		event.events = EPOLLIN;
+		event.data.ptr = data;
+		if (epoll_ctl(epoll, EPOLL_CTL_ADD, handle, &event) == -1)
+			throw std::runtime_error{ fmt::format("Failed to watch a socket : {}", strerror(errno)) };
+	}
+#endif
 }
 
 server::server(uint16_t const port) :
@@ -21,48 +43,108 @@ server::server(uint16_t const port) :
 	listener_.setBlocking(false);
 
 	next_socket_ = make_socket();
+
+#if defined(NABU_SERVER_EPOLL)
+	listener_ready_ = false;
+	epoll_ = epoll_create1(EPOLL_CLOEXEC);
+	if (epoll_ == -1)
+		throw std::runtime_error{ fmt::format("Failed to create the epoll instance : {}", strerror(errno)) };
+	watch(epoll_, listener_.getHandle(), &listener_);
+#endif
 }
 
-void server::update_new_connection() {
-	auto& socket = *next_socket_;
-	if (listener_.accept(socket) != sf::Socket::Done) return;
+server::~server() {
+#if defined(NABU_SERVER_EPOLL)
+	close(epoll_);
+#endif
+}
 
-	sockets_.push_back(std::move(next_socket_));
-	next_socket_ = make_socket();
+void server::wait(std::chrono::milliseconds const timeout) {
+#if defined(NABU_SERVER_EPOLL)
+	epoll_event events[max_events];
+	int count = epoll_wait(epoll_, events, max_events, static_cast<int>(timeout.count()));
+	if (count == -1) {
+		if (errno != EINTR) logger.warning("Failed to wait for the sockets : {}", strerror(errno));
+		count = 0;
+	}
 
-	logger.debug("new connection in {} from {}:{}",
-		socket.getLocalPort(),
-		socket.getRemoteAddress().toString(),
-		socket.getRemotePort());
+	for (int i = 0; i < count; ++i) {
+		auto const data = events[i].data.ptr;
+		if (data == &listener_) listener_ready_ = true;
+		else ready_sockets_.push_back(static_cast<detail::tcp_socket*>(data));
+	}
+#else
+	std::this_thread::sleep_for(timeout);
+#endif
 }
 
-void server::update_connections() {
+void server::update_new_connection() {
+#if defined(NABU_SERVER_EPOLL)
+	if (!std::exchange(listener_ready_, false)) return;
+#endif
+	// All the pending connections are accepted.
+	while (listener_.accept(*next_socket_) == sf::Socket::Done) {
+		auto& socket = *next_socket_;
+		sockets_.push_back(std::move(next_socket_));
+		next_socket_ = make_socket();
+#if defined(NABU_SERVER_EPOLL)
+		watch(epoll_, socket.getHandle(), &socket);
+#endif
+
+		logger.debug("new connection in {} from {}:{}",
+			socket.getLocalPort(),
+			socket.getRemoteAddress().toString(),
+			socket.getRemotePort());
+	}
+}
+
+bool server::update_connection(detail::tcp_socket& socket) {
 	using namespace std::literals;
-	char buffer[1024] = {};
-	auto i = 0u;
-	while (i < sockets_.size()) {
-		auto& socket = *sockets_[i];
+	auto const buffer = reinterpret_cast<char*>(buffer_.data());
 
-		size_t received = 0;
-		auto const status = socket.receive(buffer, sizeof(buffer), received);
+	size_t received = 0;
+	auto const status = socket.receive(buffer, buffer_.size() - 1, received);
+	if (status != sf::Socket::Disconnected && status != sf::Socket::Error && received == 0) return true;
+	buffer[received] = '\0';
 
-		if (received <= 0) { ++i; continue; }
-		buffer[received] = '\0';
+	if (status == sf::Socket::Disconnected || status == sf::Socket::Error || buffer == ":DC"s) {
+		logger.info("{}:{} has been disconnected",
+			socket.getRemoteAddress().toString(),
+			socket.getRemotePort());
+		return false;
+	}
 
-		if (status == sf::Socket::Disconnected || buffer == ":DC"s) {
-			logger.info("{}:{} has been disconnected",
-				socket.getRemoteAddress().toString(),
-				socket.getRemotePort());
-			sockets_.erase(sockets_.begin() + i);
-			continue;
-		}
+	logger.info("message from {}:{} - {}",
+		socket.getRemoteAddress().toString(),
+		socket.getRemotePort(),
+		buffer);
+	return true;
+}
 
-		logger.info("message from {}:{} - {}",
-			socket.getRemoteAddress().toString(),
-			socket.getRemotePort(),
-			buffer);
-		++i;
+void server::remove_connection(detail::tcp_socket& socket) {
+#if defined(NABU_SERVER_EPOLL)
+	epoll_ctl(epoll_, EPOLL_CTL_DEL, socket.getHandle(), nullptr);
+#endif
+	auto const it = std::find_if(sockets_.begin(), sockets_.end(), [&socket] (auto const& ptr) {
+		return ptr.get() == &socket;
+	});
+	std::iter_swap(it, sockets_.end() - 1);
+	sockets_.pop_back();
+}
+
+void server::update_connections() {
+#if defined(NABU_SERVER_EPOLL)
+	for (auto const socket : ready_sockets_) {
+		if (!update_connection(*socket)) remove_connection(*socket);
+	}
+	ready_sockets_.clear();
+#else
+	auto i = 0u;
+	while (i < sockets_.size()) {
+		if (update_connection(*sockets_[i])) ++i;
+		else remove_connection(*sockets_[i]);
 	}
+#endif
 }
 
 void server::update() {